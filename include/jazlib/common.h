@@ -1,6 +1,8 @@
 #ifndef __JAZLIB__COMMON_H__
 #define __JAZLIB__COMMON_H__
 
+#include <stddef.h>
+
 #include "jazlib/gen_hash_common.h"
 
 gh_hash_t hash_djb2(const char* key);
@@ -13,4 +15,46 @@ gh_hash_t hash_sdbm(const char* key);
  */
 int gen_strcpy(void *context, const char *v, const char **t);
 
+/*
+ * Length-carrying string key for gen_hash.h
+ * ptr need not be NUL-terminated, so lookups can be made directly against
+ * a slice of a larger buffer. hash caches the key's hash code; 0 means not
+ * yet computed. Stored copies made by gen_strview_copy() always have it set,
+ * so resizing never rehashes the key bytes.
+ *
+ * #define GEN_HASH_HASH_FUNC   hash_strview
+ * #define GEN_HASH_KEY_CMP     gen_strview_cmp
+ * #define GEN_HASH_KEY_COPY    gen_strview_copy
+ * #define GEN_HASH_KEY_FREE    gen_strview_free
+ */
+typedef struct gen_strview {
+    const char  *ptr;
+    size_t      len;
+    gh_hash_t   hash;
+} gen_strview_t;
+
+/* view of len bytes at ptr, hash not computed */
+gen_strview_t gen_strview(const char *ptr, size_t len);
+
+/* view of len bytes at ptr with hash precomputed, for keys used repeatedly */
+gen_strview_t gen_strview_hashed(const char *ptr, size_t len);
+
+/* djb2 over the view's bytes; returns the cached hash if present */
+gh_hash_t hash_strview(gen_strview_t key);
+
+/*
+ * Returns 0 if l and r hold the same bytes, non-zero otherwise
+ * Cached hashes, then lengths, are compared before the bytes themselves
+ */
+int gen_strview_cmp(gen_strview_t l, gen_strview_t r);
+
+/*
+ * Copies v's bytes into a new NUL-terminated allocation and stores a view of
+ * it, with hash cached, in *t
+ * Returns 0 on failure, non-zero on success
+ */
+int gen_strview_copy(void *context, gen_strview_t v, gen_strview_t *t);
+
+void gen_strview_free(void *context, gen_strview_t v);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+/*
+ * Blocked Bloom filter over hash codes.
+ *
+ * An approximate membership filter for rejecting most lookups of absent keys
+ * without touching the table they guard. The filter is split into 32-byte
+ * blocks; each hash code selects one block and sets/tests one bit in each of
+ * its eight 32-bit words. Blocks are aligned to GH_FILTER_ALIGN (64) bytes
+ * within the supplied storage, so a query touches a single cache line.
+ *
+ * The filter operates on gh_hash_t hash codes rather than keys, so any hash
+ * function may be used; codes are remixed internally, so weak hashes (e.g.
+ * hash_djb2, or identity for integer keys) are fine. Storage is supplied by
+ * the caller and need not be aligned; gh_filter_size() includes the slack
+ * needed to align it. Keys cannot be removed: to forget deleted keys, clear the filter
+ * and re-add the live ones (gen_hash does this whenever it resizes; see
+ * GEN_HASH_FILTER).
+ *
+ * size_t sz = gh_filter_size(expected_keys, GH_FILTER_DEFAULT_BITS_PER_KEY);
+ * gh_filter_t f;
+ * gh_filter_init(&f, malloc(sz), sz);
+ * gh_filter_add(&f, hash_djb2("foo"));
+ * if (!gh_filter_test(&f, hash_djb2("bar"))) ... definitely absent ...
+ * free(f.storage);
+ */
+
+#ifndef __JAZLIB__GEN_FILTER_H__
+#define __JAZLIB__GEN_FILTER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "jazlib/gen_hash_common.h"
+
+#define GH_FILTER_BLOCK_WORDS           8
+#define GH_FILTER_BLOCK_BYTES           (GH_FILTER_BLOCK_WORDS * sizeof(uint32_t))
+#define GH_FILTER_ALIGN                 64
+
+/* bytes of storage required for a filter of n_blocks blocks, including alignment slack */
+#define GH_FILTER_STORAGE_SIZE(n_blocks) ((n_blocks) * GH_FILTER_BLOCK_BYTES + GH_FILTER_ALIGN - 1)
+
+/* ~1% false positive rate */
+#define GH_FILTER_DEFAULT_BITS_PER_KEY  10
+
+typedef struct gh_filter {
+    uint32_t        n_blocks;
+    uint32_t        *words;         /* n_blocks * GH_FILTER_BLOCK_WORDS words, GH_FILTER_ALIGN aligned */
+    void            *storage;       /* storage passed to gh_filter_init(), for freeing */
+} gh_filter_t;
+
+/* murmur3 finalizer; spreads every input bit across the output */
+static inline uint64_t __gh_filter_mix(gh_hash_t hc) {
+    uint64_t h = (uint64_t)hc;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/* returns the number of bytes of storage required for n_keys keys */
+static inline size_t gh_filter_size(size_t n_keys, size_t bits_per_key) {
+    size_t n_blocks = (n_keys * bits_per_key + (GH_FILTER_BLOCK_BYTES * 8) - 1) / (GH_FILTER_BLOCK_BYTES * 8);
+    return GH_FILTER_STORAGE_SIZE(n_blocks ? n_blocks : 1);
+}
+
+static inline void __gh_filter_place(gh_filter_t *f, void *storage, size_t sz) {
+    f->storage = storage;
+    f->n_blocks = (sz - (GH_FILTER_ALIGN - 1)) / GH_FILTER_BLOCK_BYTES;
+    f->words = (uint32_t *)(((uintptr_t)storage + GH_FILTER_ALIGN - 1) & ~(uintptr_t)(GH_FILTER_ALIGN - 1));
+}
+
+/* initialise an empty filter over caller-supplied storage of sz bytes, as given by gh_filter_size() */
+static inline void gh_filter_init(gh_filter_t *f, void *storage, size_t sz) {
+    __gh_filter_place(f, storage, sz);
+    memset(f->words, 0, f->n_blocks * GH_FILTER_BLOCK_BYTES);
+}
+
+/* initialise dst as a copy of src over storage of GH_FILTER_STORAGE_SIZE(src->n_blocks) bytes */
+static inline void gh_filter_copy(gh_filter_t *dst, const gh_filter_t *src, void *storage) {
+    __gh_filter_place(dst, storage, GH_FILTER_STORAGE_SIZE(src->n_blocks));
+    memcpy(dst->words, src->words, src->n_blocks * GH_FILTER_BLOCK_BYTES);
+}
+
+static inline void gh_filter_clear(gh_filter_t *f) {
+    memset(f->words, 0, f->n_blocks * GH_FILTER_BLOCK_BYTES);
+}
+
+static inline uint32_t *__gh_filter_block(const gh_filter_t *f, uint64_t h) {
+    return f->words + (((h >> 32) * f->n_blocks) >> 32) * GH_FILTER_BLOCK_WORDS;
+}
+
+static const uint32_t __gh_filter_salt[GH_FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+static inline void gh_filter_add(gh_filter_t *f, gh_hash_t hc) {
+    uint64_t h = __gh_filter_mix(hc);
+    uint32_t *block = __gh_filter_block(f, h);
+    uint32_t key = (uint32_t)h;
+    int i;
+    for (i = 0; i < GH_FILTER_BLOCK_WORDS; i++) {
+        block[i] |= 1U << ((key * __gh_filter_salt[i]) >> 27);
+    }
+}
+
+/* returns 0 if hc was definitely never added, 1 if it may have been */
+static inline int gh_filter_test(const gh_filter_t *f, gh_hash_t hc) {
+    uint64_t h = __gh_filter_mix(hc);
+    const uint32_t *block = __gh_filter_block(f, h);
+    uint32_t key = (uint32_t)h;
+    int i;
+    for (i = 0; i < GH_FILTER_BLOCK_WORDS; i++) {
+        if (!(block[i] & (1U << ((key * __gh_filter_salt[i]) >> 27)))) return 0;
+    }
+    return 1;
+}
+
+#endif
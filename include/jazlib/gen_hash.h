@@ -20,6 +20,14 @@
  * #define GEN_HASH_KEY_FREE    free
  * #include "gen_hash.h"
  * GEN_HASH_INIT(typename, const char *, int);
+ *
+ * Tables that usually hold only a handful of entries can be kept in a small
+ * inline array, searched linearly without hashing, until they outgrow it
+ * (see GEN_HASH_INLINE_CAPACITY below).
+ *
+ * Tables that see many lookups of absent keys can keep a Bloom filter
+ * alongside the buckets, rejecting most misses without probing
+ * (see GEN_HASH_FILTER below).
  */
 
 #ifndef __JAZLIB__GEN_HASH_H__
@@ -125,6 +133,12 @@
     #define __gh_key_copy(hsh,target,value) ((target = value), 1)
 #endif
 
+#ifdef GEN_HASH_KEY_COPY
+    #define __gh_key_copy_is_raw 0
+#else
+    #define __gh_key_copy_is_raw 1
+#endif
+
 #ifdef GEN_HASH_KEY_FREE
     #define __gh_key_free(hsh,k) (GEN_HASH_KEY_FREE(hsh->userdata, k))
 #else
@@ -143,23 +157,101 @@
     #define __gh_value_copy(hsh,target,value) ((target = value), 1)
 #endif
 
+#ifdef GEN_HASH_VALUE_COPY
+    #define __gh_value_copy_is_raw 0
+#else
+    #define __gh_value_copy_is_raw 1
+#endif
+
 #ifdef GEN_HASH_VALUE_FREE
     #define __gh_value_free(hsh,v) (GEN_HASH_VALUE_FREE(hsh->userdata, v))
 #else
     #define __gh_value_free(hsh,v)
 #endif
 
+/*
+ * number of entries to store inline, inside the hash struct itself.
+ * while a hash holds no more than this many entries it stays in "small mode":
+ * no bucket or flag arrays are allocated, and lookups are a linear scan using
+ * the key comparison function, without hashing. the first insertion beyond
+ * this capacity promotes the hash to a regular open-addressed table, which it
+ * remains thereafter.
+ *
+ * while in small mode, find_slot() returns an index into inline_nodes, and
+ * GEN_HASH_INLINE_CAPACITY (rather than n_buckets) when the key is not found.
+ *
+ * must be defined identically wherever GEN_HASH_DECLARE and GEN_HASH_INIT
+ * are expanded for a given type, as it changes the struct layout.
+ */
+#ifdef GEN_HASH_INLINE_CAPACITY
+    #define __gh_inline_capacity            (GEN_HASH_INLINE_CAPACITY)
+    #define __gh_inline_storage(type)       type##_node_t inline_nodes[GEN_HASH_INLINE_CAPACITY];
+    #define __gh_inline_nodes(hsh)          ((hsh)->inline_nodes)
+    #define __gh_is_small(hsh)              ((hsh)->n_buckets == 0)
+#else
+    #define __gh_inline_capacity            0
+    #define __gh_inline_storage(type)
+    #define __gh_inline_nodes(hsh)          ((hsh)->buckets)
+    #define __gh_is_small(hsh)              0
+#endif
+
+#define __gh_slot_none(hsh)                 (__gh_is_small(hsh) ? __gh_inline_capacity : (hsh)->n_buckets)
+#define __gh_node(hsh, slot)                ((__gh_is_small(hsh) ? __gh_inline_nodes(hsh) : (hsh)->buckets)[slot])
+
+/*
+ * maintain a blocked Bloom filter (see gen_filter.h) over the keys in the table.
+ * find_slot() - and hence contains/read/delete - consults the filter before
+ * probing, so most lookups of absent keys cost one hash and one cache line
+ * rather than a walk along the probe chain comparing keys.
+ * deleted keys are not removed from the filter; it is rebuilt from the live
+ * keys each time the table is resized (which includes the rehash triggered by
+ * accumulated deletions), so stale bits never outlive a resize.
+ *
+ * GEN_HASH_FILTER_BITS_PER_KEY sets the filter size relative to the table's
+ * maximum occupancy, trading memory for false positive rate.
+ * the filter is not used while a table is in small mode.
+ */
+#ifdef GEN_HASH_FILTER
+    #include "jazlib/gen_filter.h"
+    #ifndef GEN_HASH_FILTER_BITS_PER_KEY
+        #define GEN_HASH_FILTER_BITS_PER_KEY GH_FILTER_DEFAULT_BITS_PER_KEY
+    #endif
+    #define __gh_filter_storage                 gh_filter_t filter;
+    #define __gh_filter_local(f)                gh_filter_t f;
+    #define __gh_filter_alloc(hsh, f, n_keys) \
+        (((f).storage = __gh_malloc(hsh, gh_filter_size(n_keys, GEN_HASH_FILTER_BITS_PER_KEY))) \
+            ? (gh_filter_init(&(f), (f).storage, gh_filter_size(n_keys, GEN_HASH_FILTER_BITS_PER_KEY)), 1) : 0)
+    #define __gh_filter_free(hsh, f)            __gh_free(hsh, (f).storage)
+    #define __gh_filter_reset(hsh)              ((hsh)->filter.words = NULL, (hsh)->filter.storage = NULL)
+    #define __gh_filter_clone(dst, src) \
+        (!(src)->filter.words || (((dst)->filter.storage = __gh_malloc(dst, GH_FILTER_STORAGE_SIZE((src)->filter.n_blocks))) \
+            && (gh_filter_copy(&(dst)->filter, &(src)->filter, (dst)->filter.storage), 1)))
+    #define __gh_filter_replace(hsh, f)         (__gh_free(hsh, (hsh)->filter.storage), (hsh)->filter = (f))
+    #define __gh_filter_add(f, hc)              gh_filter_add(&(f), hc)
+    #define __gh_filter_clear(hsh)              gh_filter_clear(&(hsh)->filter)
+    #define __gh_filter_test(hsh, hc)           gh_filter_test(&(hsh)->filter, hc)
+#else
+    #define __gh_filter_storage
+    #define __gh_filter_local(f)
+    #define __gh_filter_alloc(hsh, f, n_keys)   1
+    #define __gh_filter_free(hsh, f)
+    #define __gh_filter_reset(hsh)
+    #define __gh_filter_clone(dst, src)         1
+    #define __gh_filter_replace(hsh, f)
+    #define __gh_filter_add(f, hc)
+    #define __gh_filter_clear(hsh)
+    #define __gh_filter_test(hsh, hc)           1
+#endif
+
+/* iterate over a hash's entries: for (ix = 0; ix < __gh_iter_end(hsh); ix++) if (__gh_iter_valid(hsh, ix)) ... */
+#define __gh_iter_end(hsh)                  (__gh_is_small(hsh) ? (hsh)->size : (hsh)->n_buckets)
+#define __gh_iter_valid(hsh, ix)            (__gh_is_small(hsh) || GH_BUCKET_STATE((hsh)->flags, ix) == GH_BUCKET_FULL)
+
 /*
  * End Configuration
  */
  
-#define GEN_HASH_DECLARE_STORAGE(type, key_t, value_t) \
-    typedef struct type##_node type##_node_t; \
-    struct type##_node { \
-        key_t           key; \
-        value_t         value; \
-    }; \
-    \
+#define __GEN_HASH_DECLARE_TABLE(type) \
     typedef struct type { \
         gh_hash_t       n_buckets;		/* # of buckets allocated */ \
         gh_hash_t       n_occupied;		/* # of occupied buckets (i.e. full or deleted) */ \
@@ -168,7 +260,18 @@
         unsigned char   *flags;			/* auxiliary packed flag array for tracking bucket states */ \
         type##_node_t   *buckets;		/* the buckets */ \
         void			*userdata;		/* custom userdata. mainly useful for passing context into user-defined memory mgmt functions */ \
+        __gh_inline_storage(type)       /* inline entries, used in small mode only */ \
+        __gh_filter_storage             /* filter over keys in buckets, if GEN_HASH_FILTER */ \
     } type##_t;
+
+#define GEN_HASH_DECLARE_STORAGE(type, key_t, value_t) \
+    typedef struct type##_node type##_node_t; \
+    struct type##_node { \
+        key_t           key; \
+        value_t         value; \
+    }; \
+    \
+    __GEN_HASH_DECLARE_TABLE(type)
     
 #define GEN_HASH_DECLARE_INTERFACE(type, key_t, value_t) \
     void        type##_init(type##_t *hsh); \
@@ -177,7 +280,9 @@
     int         type##_read(type##_t *hsh, key_t k, value_t *v); \
     int         type##_put(type##_t *hsh, key_t k, value_t v); \
     int         type##_delete(type##_t *hsh, key_t k); \
-    gh_hash_t   type##_size(type##_t *hsh);
+    gh_hash_t   type##_size(type##_t *hsh); \
+    int         type##_clone(type##_t *dst, type##_t *src); \
+    __gh_build_parallel_decl(type, key_t, value_t)
     
 #define GEN_HASH_DECLARE_STATIC_INTERFACE(type, key_t, value_t) \
     static void         type##_init(type##_t *hsh); \
@@ -186,16 +291,57 @@
     static int          type##_read(type##_t *hsh, key_t k, value_t *v); \
     static int          type##_put(type##_t *hsh, key_t k, value_t v); \
     static int          type##_delete(type##_t *hsh, key_t k); \
-    static gh_hash_t    type##_size(type##_t *hsh);
+    static gh_hash_t    type##_size(type##_t *hsh); \
+    static int          type##_clone(type##_t *dst, type##_t *src);
 
-#define GEN_HASH_INIT(type, key_t, value_t) \
+/*
+ * Table machinery shared by GEN_HASH and GEN_HASH_SET; touches keys only and
+ * moves whole nodes, so is agnostic as to whether nodes carry a value.
+ */
+#define __GEN_HASH_INIT_TABLE(type, key_t) \
     static const gh_hash_t type##_primes[] = { \
         GEN_HASH_BUCKET_SIZES\
     }; \
     static const gh_hash_t type##_n_primes = (sizeof(type##_primes)/sizeof(gh_hash_t)); \
     \
+    /* \
+     * move every full bucket to its position in a table of new_buckets buckets, \
+     * marking it in new_flags (which must be zeroed) and adding it to the \
+     * filter. buckets must already have room for new_buckets nodes. \
+     */ \
+    static void __##type##_rehash_nodes(type##_t *hsh, unsigned char *new_flags, gh_hash_t new_buckets) { \
+        int j; \
+        for (j = 0; j < hsh->n_buckets; j++) { \
+            if (GH_BUCKET_STATE(hsh->flags, j) == GH_BUCKET_FULL) { \
+                type##_node_t node = hsh->buckets[j]; \
+                GH_SET_BUCKET_STATE(hsh->flags, j, GH_BUCKET_DELETED); \
+                while (1) { \
+                    gh_hash_t hc    = __gh_hash_key(node.key); \
+                    gh_hash_t hb    = hc % new_buckets; \
+                    gh_hash_t inc   = 1 + hc % (new_buckets - 1); \
+                    while (GH_BUCKET_STATE(new_flags, hb) != GH_BUCKET_EMPTY) { \
+                        hb += inc; \
+                        if (hb >= new_buckets) hb -= new_buckets; \
+                    } \
+                    GH_SET_BUCKET_STATE(new_flags, hb, GH_BUCKET_FULL); \
+                    __gh_filter_add(hsh->filter, hc); \
+                    if (hb < hsh->n_buckets && GH_BUCKET_STATE(hsh->flags, hb) == GH_BUCKET_FULL) { \
+                        type##_node_t tmp = hsh->buckets[hb]; \
+                        hsh->buckets[hb] = node; \
+                        node = tmp; \
+                        GH_SET_BUCKET_STATE(hsh->flags, hb, GH_BUCKET_DELETED); \
+                    } else { \
+                        hsh->buckets[hb] = node; \
+                        break; \
+                    } \
+                } \
+            } \
+        } \
+    } \
+    \
     int __##type##_resize(type##_t *hsh, gh_hash_t new_buckets) { \
         unsigned char *new_flags = NULL; \
+        __gh_filter_local(new_filter) \
         gh_hash_t pix = type##_n_primes - 1; \
         while (type##_primes[pix] > new_buckets) pix--; \
         new_buckets = type##_primes[pix+1]; \
@@ -208,44 +354,20 @@
         new_flags = __gh_malloc(hsh, new_flags_size); \
         if (!new_flags) return 0; \
         memset(new_flags, 0, new_flags_size); \
+        if (!__gh_filter_alloc(hsh, new_filter, (gh_hash_t)(new_buckets * GEN_HASH_MAX_LOAD + 0.5))) { \
+            __gh_free(hsh, new_flags); \
+            return 0; \
+        } \
         if (new_buckets > hsh->n_buckets) { \
             hsh->buckets = __gh_realloc(hsh, hsh->buckets, new_buckets * sizeof(type##_node_t)); \
             if (!hsh->buckets) { \
                 __gh_free(hsh, new_flags); \
+                __gh_filter_free(hsh, new_filter); \
                 return 0; \
             } \
         } \
-        int j; \
-        for (j = 0; j < hsh->n_buckets; j++) { \
-            if (GH_BUCKET_STATE(hsh->flags, j) == GH_BUCKET_FULL) { \
-                key_t key = hsh->buckets[j].key; \
-                value_t val = hsh->buckets[j].value; \
-                GH_SET_BUCKET_STATE(hsh->flags, j, GH_BUCKET_DELETED); \
-                while (1) { \
-                    gh_hash_t hc    = __gh_hash_key(key); \
-                    gh_hash_t hb    = hc % new_buckets; \
-                    gh_hash_t inc   = 1 + hc % (new_buckets - 1); \
-                    while (GH_BUCKET_STATE(new_flags, hb) != GH_BUCKET_EMPTY) { \
-                        hb += inc; \
-                        if (hb >= new_buckets) hb -= new_buckets; \
-                    } \
-                    GH_SET_BUCKET_STATE(new_flags, hb, GH_BUCKET_FULL); \
-                    if (hb < hsh->n_buckets && GH_BUCKET_STATE(hsh->flags, hb) == GH_BUCKET_FULL) { \
-                        key_t tmp_key = hsh->buckets[hb].key; \
-                        value_t tmp_val = hsh->buckets[hb].value; \
-                        hsh->buckets[hb].key = key; \
-                        hsh->buckets[hb].value = val; \
-                        key = tmp_key; \
-                        val = tmp_val; \
-                        GH_SET_BUCKET_STATE(hsh->flags, hb, GH_BUCKET_DELETED); \
-                    } else { \
-                        hsh->buckets[hb].key = key; \
-                        hsh->buckets[hb].value = val; \
-                        break; \
-                    } \
-                } \
-            } \
-        } \
+        __gh_filter_replace(hsh, new_filter); \
+        __##type##_rehash_nodes(hsh, new_flags, new_buckets); \
         \
         if (new_buckets < hsh->n_buckets) { \
             hsh->buckets = __gh_realloc(hsh, hsh->buckets, new_buckets * sizeof(type##_node_t)); \
@@ -262,25 +384,58 @@
         return 1; \
     } \
     \
-    void type##_init(type##_t *hsh) { \
-        memset(hsh, 0, sizeof(type##_t)); \
+    /* \
+     * clear tombstones by rehashing at the current size, without allocating. \
+     * spare_flags must have room for the table's flags; the table takes it \
+     * over and the old flags array is returned for the next call. \
+     */ \
+    unsigned char *__##type##_rehash_in_place(type##_t *hsh, unsigned char *spare_flags) { \
+        unsigned char *old_flags = hsh->flags; \
+        memset(spare_flags, 0, sizeof(unsigned char) * ((hsh->n_buckets >> 2) + 1)); \
+        __gh_filter_clear(hsh); \
+        __##type##_rehash_nodes(hsh, spare_flags, hsh->n_buckets); \
+        hsh->flags = spare_flags; \
+        hsh->n_occupied = hsh->size; \
+        return old_flags; \
     } \
     \
-    void type##_dealloc(type##_t *hsh) { \
-    	gh_hash_t ix = 0; \
-    	for (ix = 0; ix < hsh->n_buckets; ix++) { \
-    		if (GH_BUCKET_STATE(hsh->flags, ix) == GH_BUCKET_FULL) { \
-    			__gh_key_free(hsh, hsh->buckets[ix].key); \
-    			__gh_value_free(hsh, hsh->buckets[ix].value); \
-    		} \
-    	} \
-    	__gh_free(hsh, hsh->flags); \
-    	__gh_free(hsh, hsh->buckets); \
+    /* move all inline entries into a freshly allocated table */ \
+    int __##type##_promote(type##_t *hsh) { \
+        gh_hash_t n = hsh->size; \
+        if (!__##type##_resize(hsh, (n + 1) / GEN_HASH_MAX_LOAD + 1)) { \
+            return 0; \
+        } \
+        gh_hash_t ix; \
+        for (ix = 0; ix < n; ix++) { \
+            gh_hash_t hc    = __gh_hash_key(__gh_inline_nodes(hsh)[ix].key); \
+            gh_hash_t hb    = hc % hsh->n_buckets; \
+            gh_hash_t inc   = 1 + hc % (hsh->n_buckets - 1); \
+            while (GH_BUCKET_STATE(hsh->flags, hb) != GH_BUCKET_EMPTY) { \
+                hb += inc; \
+                if (hb >= hsh->n_buckets) hb -= hsh->n_buckets; \
+            } \
+            hsh->buckets[hb] = __gh_inline_nodes(hsh)[ix]; \
+            GH_SET_BUCKET_STATE(hsh->flags, hb, GH_BUCKET_FULL); \
+            __gh_filter_add(hsh->filter, hc); \
+        } \
+        hsh->n_occupied = n; \
+        return 1; \
+    } \
+    \
+    void type##_init(type##_t *hsh) { \
+        memset(hsh, 0, sizeof(type##_t)); \
     } \
     \
     gh_hash_t type##_find_slot(type##_t *hsh, key_t k) { \
-        if (hsh->n_buckets) { \
+        if (__gh_is_small(hsh)) { \
+            gh_hash_t ix; \
+            for (ix = 0; ix < hsh->size; ix++) { \
+                if (__gh_key_cmp(__gh_inline_nodes(hsh)[ix].key, k)) return ix; \
+            } \
+            return __gh_inline_capacity; \
+        } else if (hsh->n_buckets) { \
             gh_hash_t hc    = __gh_hash_key(k); \
+            if (!__gh_filter_test(hsh, hc)) return hsh->n_buckets; \
             gh_hash_t hb    = hc % hsh->n_buckets; \
             gh_hash_t inc   = 1 + hc % (hsh->n_buckets - 1); \
             gh_hash_t last  = hb; \
@@ -300,24 +455,34 @@
     } \
     \
     int type##_contains(type##_t *hsh, key_t k) { \
-    	return type##_find_slot(hsh, k) != hsh->n_buckets; \
+    	return type##_find_slot(hsh, k) != __gh_slot_none(hsh); \
     } \
     \
-    int type##_read(type##_t *hsh, key_t k, value_t *v) { \
-        gh_hash_t slot = type##_find_slot(hsh, k); \
-        if (slot == hsh->n_buckets) { \
-            return 0; \
-        } else { \
-            *v = hsh->buckets[slot].value; \
-            return 1; \
+    /* \
+     * locate the slot into which key k should be written, growing (or promoting) \
+     * the table as necessary. if k is already present *found is set to 1 and its \
+     * node may have been relocated to the returned slot; otherwise *found is set \
+     * to 0 and the caller should fill in the node and then call __type_commit(). \
+     * returns __gh_slot_none(hsh) on allocation failure. \
+     */ \
+    gh_hash_t __##type##_insert_slot(type##_t *hsh, key_t k, int *found) { \
+        \
+        if (__gh_is_small(hsh)) { \
+            gh_hash_t slot = type##_find_slot(hsh, k); \
+            if (slot != __gh_inline_capacity) { \
+                *found = 1; \
+                return slot; \
+            } else if (hsh->size < __gh_inline_capacity) { \
+                *found = 0; \
+                return hsh->size; \
+            } else if (!__##type##_promote(hsh)) { \
+                return __gh_inline_capacity; \
+            } \
         } \
-    } \
-    \
-    int type##_put(type##_t *hsh, key_t k, value_t v) { \
         \
         if (hsh->n_occupied >= hsh->upper_bound) { \
             if (!__##type##_resize(hsh, hsh->n_buckets + ((hsh->n_buckets > (hsh->size * 2)) ? -1 : 1))) { \
-                return 0; \
+                return hsh->n_buckets; \
             } \
         } \
         \
@@ -343,24 +508,376 @@
             if (hb >= hsh->n_buckets) hb -= hsh->n_buckets; \
         } \
         \
-        if (old != hsh->n_buckets) { /* replace */ \
-        	__gh_value_free(hsh, hsh->buckets[old].value); \
-            if (!__gh_value_copy(hsh, hsh->buckets[tgt].value, v)) { \
-                return 0; \
-            } \
-            if (old != tgt) { \
-            	hsh->buckets[tgt].key = hsh->buckets[old].key; \
+        if (old != hsh->n_buckets) { \
+            *found = 1; \
+            if (old != tgt) { /* move existing node to earlier tombstone */ \
+                hsh->buckets[tgt] = hsh->buckets[old]; \
                 GH_SET_BUCKET_STATE(hsh->flags, old, GH_BUCKET_DELETED); \
                 GH_SET_BUCKET_STATE(hsh->flags, tgt, GH_BUCKET_FULL); \
             } \
+        } else { \
+            *found = 0; \
+            __gh_filter_add(hsh->filter, hc); \
+        } \
+        \
+        return tgt; \
+    } \
+    \
+    /* mark a slot returned by __type_insert_slot() as holding a new entry */ \
+    void __##type##_commit(type##_t *hsh, gh_hash_t slot) { \
+        if (!__gh_is_small(hsh)) { \
+            if (GH_BUCKET_STATE(hsh->flags, slot) == GH_BUCKET_EMPTY) hsh->n_occupied++; \
+            GH_SET_BUCKET_STATE(hsh->flags, slot, GH_BUCKET_FULL); \
+        } \
+        hsh->size++; \
+    } \
+    \
+    /* remove the entry at slot; its key/value must already have been freed */ \
+    void __##type##_remove_slot(type##_t *hsh, gh_hash_t slot) { \
+        if (__gh_is_small(hsh)) { \
+            __gh_inline_nodes(hsh)[slot] = __gh_inline_nodes(hsh)[hsh->size - 1]; \
+        } else { \
+            GH_SET_BUCKET_STATE(hsh->flags, slot, GH_BUCKET_DELETED); \
+        } \
+        hsh->size--; \
+    } \
+    \
+    gh_hash_t type##_size(type##_t *hsh) { \
+        return hsh->size; \
+    } \
+    \
+    /* free a partially cloned dst's arrays and leave it empty, keeping its userdata */ \
+    static void __##type##_clone_abort(type##_t *dst) { \
+        void *userdata = dst->userdata; \
+        __gh_free(dst, dst->flags); \
+        __gh_free(dst, dst->buckets); \
+        __gh_filter_free(dst, dst->filter); \
+        type##_init(dst); \
+        dst->userdata = userdata; \
+    } \
+    \
+    /* \
+     * make dst a bitwise copy of src, with its own flag/bucket/filter arrays. \
+     * keys and values are copied by assignment; callers using copy functions \
+     * must then run them over dst's entries. returns 0 on failure, leaving \
+     * dst empty. \
+     */ \
+    int __##type##_clone_table(type##_t *dst, type##_t *src) { \
+        *dst = *src; \
+        dst->flags = NULL; \
+        dst->buckets = NULL; \
+        __gh_filter_reset(dst); \
+        if (src->n_buckets) { \
+            gh_hash_t flags_size = sizeof(unsigned char) * ((src->n_buckets >> 2) + 1); \
+            dst->flags = __gh_malloc(dst, flags_size); \
+            dst->buckets = __gh_malloc(dst, src->n_buckets * sizeof(type##_node_t)); \
+            if (!dst->flags || !dst->buckets || !__gh_filter_clone(dst, src)) { \
+                __##type##_clone_abort(dst); \
+                return 0; \
+            } \
+            memcpy(dst->flags, src->flags, flags_size); \
+            memcpy(dst->buckets, src->buckets, src->n_buckets * sizeof(type##_node_t)); \
+        } \
+        return 1; \
+    } \
+
+/*
+ * Parallel bulk build (GEN_HASH_PARALLEL_BUILD)
+ *
+ * type_build_parallel(hsh, keys, values, n, nthreads) inserts n K/V pairs
+ * using nthreads pthreads, with the same semantics as calling put() for each
+ * pair in turn (so for duplicate keys, the last value wins):
+ *
+ * 1. keys are hashed in parallel, each thread taking a contiguous chunk
+ * 2. keys are radix-partitioned by home bucket into one bucket region per
+ *    thread, preserving input order within each region
+ * 3. each thread inserts its partition into its own region without locking.
+ *    a key whose probe sequence would leave the region is deferred, and all
+ *    deferred keys are inserted sequentially once the threads are done,
+ *    resuming their probes where they left off (no key is hashed twice).
+ *
+ * because double hashing steps are spread over the whole table, almost any
+ * key that misses its home bucket leaves its region. at final load a, about
+ * 1 - (1 - e^-a) / a of keys are deferred: ~20% at a = 0.5, ~28% at a = 0.7.
+ * the sequential pass therefore bounds the achievable speedup.
+ *
+ * regions are aligned so that no byte of the packed flag array is shared
+ * between threads. the key/value copy & free functions, and any custom
+ * memory management functions, must be safe to call concurrently.
+ */
+#ifdef GEN_HASH_PARALLEL_BUILD
+    #include <pthread.h>
+
+    /* below this many pairs, build_parallel() simply calls put() */
+    #ifndef GEN_HASH_PARALLEL_BUILD_MIN
+        #define GEN_HASH_PARALLEL_BUILD_MIN 4096
+    #endif
+
+    #define __gh_build_parallel_decl(type, key_t, value_t) \
+        int type##_build_parallel(type##_t *hsh, key_t *keys, value_t *values, gh_hash_t n, int nthreads);
+
+    #define __GEN_HASH_INIT_BUILD_PARALLEL(type, key_t, value_t) \
+        typedef struct __##type##_build { \
+            type##_t        *hsh; \
+            key_t           *keys; \
+            value_t         *values; \
+            gh_hash_t       n; \
+            int             nthreads; \
+            int             phase; \
+            gh_hash_t       region_size;    /* # of buckets per region; multiple of 64 */ \
+            gh_hash_t       *hc;            /* hash code of each key */ \
+            gh_hash_t       *perm;          /* key indices, grouped by region */ \
+            gh_hash_t       *offsets;       /* [thread][region] histogram, then scatter offsets */ \
+            gh_hash_t       *region_start;  /* start of each region's keys in perm */ \
+            gh_hash_t       *resume;        /* bucket at which each key's probe left its region, or n_buckets */ \
+        } __##type##_build_t; \
+        \
+        typedef struct __##type##_build_worker { \
+            __##type##_build_t  *b; \
+            int                 id; \
+            gh_hash_t           inserted; \
+            int                 failed; \
+            int                 started;    /* running in its own thread */ \
+        } __##type##_build_worker_t; \
+        \
+        static void *__##type##_build_work(void *arg) { \
+            __##type##_build_worker_t *w = arg; \
+            __##type##_build_t *b = w->b; \
+            type##_t *hsh = b->hsh; \
+            gh_hash_t chunk = (b->n + b->nthreads - 1) / b->nthreads; \
+            gh_hash_t lo = chunk * w->id, hi = lo + chunk, i, j; \
+            if (hi > b->n) hi = b->n; \
+            if (lo > b->n) lo = b->n; \
+            gh_hash_t *offsets = b->offsets + w->id * b->nthreads; \
+            \
+            if (b->phase == 0) { /* hash & histogram */ \
+                for (i = lo; i < hi; i++) { \
+                    b->hc[i] = __gh_hash_key(b->keys[i]); \
+                    offsets[(b->hc[i] % hsh->n_buckets) / b->region_size]++; \
+                } \
+            } else if (b->phase == 1) { /* scatter */ \
+                for (i = lo; i < hi; i++) { \
+                    b->perm[offsets[(b->hc[i] % hsh->n_buckets) / b->region_size]++] = i; \
+                } \
+            } else { /* insert into region */ \
+                gh_hash_t rlo = b->region_size * w->id; \
+                gh_hash_t rhi = rlo + b->region_size; \
+                for (j = b->region_start[w->id]; j < b->region_start[w->id + 1]; j++) { \
+                    i = b->perm[j]; \
+                    gh_hash_t hc    = b->hc[i]; \
+                    gh_hash_t hb    = hc % hsh->n_buckets; \
+                    gh_hash_t inc   = 1 + hc % (hsh->n_buckets - 1); \
+                    while (1) { \
+                        if (hb < rlo || hb >= rhi) { \
+                            b->resume[i] = hb; \
+                            break; \
+                        } \
+                        char state = GH_BUCKET_STATE(hsh->flags, hb); \
+                        if (state == GH_BUCKET_EMPTY) { \
+                            if (!__gh_key_copy(hsh, hsh->buckets[hb].key, b->keys[i])) { \
+                                w->failed = 1; \
+                            } else if (!__gh_value_copy(hsh, hsh->buckets[hb].value, b->values[i])) { \
+                                __gh_key_free(hsh, hsh->buckets[hb].key); \
+                                w->failed = 1; \
+                            } else { \
+                                GH_SET_BUCKET_STATE(hsh->flags, hb, GH_BUCKET_FULL); \
+                                w->inserted++; \
+                            } \
+                            break; \
+                        } else if (__gh_key_cmp(hsh->buckets[hb].key, b->keys[i])) { \
+                            __gh_value_free(hsh, hsh->buckets[hb].value); \
+                            if (!__gh_value_copy(hsh, hsh->buckets[hb].value, b->values[i])) w->failed = 1; \
+                            break; \
+                        } \
+                        hb += inc; \
+                        if (hb >= hsh->n_buckets) hb -= hsh->n_buckets; \
+                    } \
+                } \
+            } \
+            return NULL; \
+        } \
+        \
+        /* run the current phase on every worker, falling back to the calling thread if a thread can't be started */ \
+        static void __##type##_build_run(__##type##_build_worker_t *workers, pthread_t *threads, int nthreads) { \
+            int t; \
+            for (t = 0; t < nthreads; t++) { \
+                workers[t].started = (pthread_create(&threads[t], NULL, __##type##_build_work, &workers[t]) == 0); \
+                if (!workers[t].started) __##type##_build_work(&workers[t]); \
+            } \
+            for (t = 0; t < nthreads; t++) { \
+                if (workers[t].started) pthread_join(threads[t], NULL); \
+            } \
+        } \
+        \
+        int type##_build_parallel(type##_t *hsh, key_t *keys, value_t *values, gh_hash_t n, int nthreads) { \
+            gh_hash_t i; \
+            int t, r, ok = 1; \
+            \
+            if (nthreads <= 1 || n < GEN_HASH_PARALLEL_BUILD_MIN) { \
+                for (i = 0; i < n; i++) { \
+                    if (!type##_put(hsh, keys[i], values[i])) return 0; \
+                } \
+                return 1; \
+            } \
+            \
+            if (__gh_is_small(hsh) && !__##type##_promote(hsh)) { \
+                return 0; \
+            } \
+            /* make room for every key up front; this also clears out any tombstones */ \
+            if (hsh->size + n >= hsh->upper_bound || hsh->n_occupied != hsh->size) { \
+                if (!__##type##_resize(hsh, (hsh->size + n) / GEN_HASH_MAX_LOAD + 1)) return 0; \
+            } \
+            \
+            __##type##_build_t b; \
+            b.hsh = hsh; \
+            b.keys = keys; \
+            b.values = values; \
+            b.n = n; \
+            b.nthreads = nthreads; \
+            b.region_size = ((hsh->n_buckets + nthreads - 1) / nthreads + 63) & ~(gh_hash_t)63; \
+            b.hc = __gh_malloc(hsh, sizeof(gh_hash_t) * n); \
+            b.perm = __gh_malloc(hsh, sizeof(gh_hash_t) * n); \
+            b.offsets = __gh_malloc(hsh, sizeof(gh_hash_t) * nthreads * nthreads); \
+            b.region_start = __gh_malloc(hsh, sizeof(gh_hash_t) * (nthreads + 1)); \
+            b.resume = __gh_malloc(hsh, sizeof(gh_hash_t) * n); \
+            __##type##_build_worker_t *workers = __gh_malloc(hsh, sizeof(__##type##_build_worker_t) * nthreads); \
+            pthread_t *threads = __gh_malloc(hsh, sizeof(pthread_t) * nthreads); \
+            \
+            if (!b.hc || !b.perm || !b.offsets || !b.region_start || !b.resume || !workers || !threads) { \
+                ok = 0; \
+                goto done; \
+            } \
+            memset(b.offsets, 0, sizeof(gh_hash_t) * nthreads * nthreads); \
+            for (i = 0; i < n; i++) b.resume[i] = hsh->n_buckets; \
+            for (t = 0; t < nthreads; t++) { \
+                workers[t].b = &b; \
+                workers[t].id = t; \
+                workers[t].inserted = 0; \
+                workers[t].failed = 0; \
+            } \
+            \
+            b.phase = 0; \
+            __##type##_build_run(workers, threads, nthreads); \
+            \
+            /* turn per-thread histograms into scatter offsets: region-major, then thread order */ \
+            gh_hash_t pos = 0; \
+            for (r = 0; r < nthreads; r++) { \
+                b.region_start[r] = pos; \
+                for (t = 0; t < nthreads; t++) { \
+                    gh_hash_t count = b.offsets[t * nthreads + r]; \
+                    b.offsets[t * nthreads + r] = pos; \
+                    pos += count; \
+                } \
+            } \
+            b.region_start[nthreads] = pos; \
+            \
+            b.phase = 1; \
+            __##type##_build_run(workers, threads, nthreads); \
+            b.phase = 2; \
+            __##type##_build_run(workers, threads, nthreads); \
+            \
+            for (t = 0; t < nthreads; t++) { \
+                hsh->size += workers[t].inserted; \
+                hsh->n_occupied += workers[t].inserted; \
+                if (workers[t].failed) ok = 0; \
+            } \
+            /* \
+             * the table was sized for every key and has no tombstones, so \
+             * deferred keys just continue probing from where they left their \
+             * region; the buckets passed over so far can only have filled up. \
+             */ \
+            for (i = 0; i < n; i++) { \
+                gh_hash_t hb = b.resume[i]; \
+                if (hb != hsh->n_buckets) { \
+                    gh_hash_t inc = 1 + b.hc[i] % (hsh->n_buckets - 1); \
+                    while (1) { \
+                        if (GH_BUCKET_STATE(hsh->flags, hb) == GH_BUCKET_EMPTY) { \
+                            if (!__gh_key_copy(hsh, hsh->buckets[hb].key, keys[i])) { \
+                                ok = 0; \
+                            } else if (!__gh_value_copy(hsh, hsh->buckets[hb].value, values[i])) { \
+                                __gh_key_free(hsh, hsh->buckets[hb].key); \
+                                ok = 0; \
+                            } else { \
+                                GH_SET_BUCKET_STATE(hsh->flags, hb, GH_BUCKET_FULL); \
+                                hsh->size++; \
+                                hsh->n_occupied++; \
+                            } \
+                            break; \
+                        } else if (__gh_key_cmp(hsh->buckets[hb].key, keys[i])) { \
+                            __gh_value_free(hsh, hsh->buckets[hb].value); \
+                            if (!__gh_value_copy(hsh, hsh->buckets[hb].value, values[i])) ok = 0; \
+                            break; \
+                        } \
+                        hb += inc; \
+                        if (hb >= hsh->n_buckets) hb -= hsh->n_buckets; \
+                    } \
+                } \
+                __gh_filter_add(hsh->filter, b.hc[i]); \
+            } \
+            \
+        done: \
+            __gh_free(hsh, b.hc); \
+            __gh_free(hsh, b.perm); \
+            __gh_free(hsh, b.offsets); \
+            __gh_free(hsh, b.region_start); \
+            __gh_free(hsh, b.resume); \
+            __gh_free(hsh, workers); \
+            __gh_free(hsh, threads); \
+            return ok; \
+        }
+#else
+    #define __gh_build_parallel_decl(type, key_t, value_t)
+    #define __GEN_HASH_INIT_BUILD_PARALLEL(type, key_t, value_t)
+#endif
+
+#define GEN_HASH_INIT(type, key_t, value_t) \
+    __GEN_HASH_INIT_TABLE(type, key_t) \
+    \
+    void type##_dealloc(type##_t *hsh) { \
+    	gh_hash_t ix = 0; \
+    	for (ix = 0; ix < __gh_iter_end(hsh); ix++) { \
+    		if (__gh_iter_valid(hsh, ix)) { \
+    			__gh_key_free(hsh, __gh_node(hsh, ix).key); \
+    			__gh_value_free(hsh, __gh_node(hsh, ix).value); \
+    		} \
+    	} \
+    	__gh_free(hsh, hsh->flags); \
+    	__gh_free(hsh, hsh->buckets); \
+    	__gh_filter_free(hsh, hsh->filter); \
+    } \
+    \
+    int type##_read(type##_t *hsh, key_t k, value_t *v) { \
+        gh_hash_t slot = type##_find_slot(hsh, k); \
+        if (slot == __gh_slot_none(hsh)) { \
+            return 0; \
+        } else { \
+            *v = __gh_node(hsh, slot).value; \
+            return 1; \
+        } \
+    } \
+    \
+    int type##_put(type##_t *hsh, key_t k, value_t v) { \
+        int found; \
+        gh_hash_t slot = __##type##_insert_slot(hsh, k, &found); \
+        if (slot == __gh_slot_none(hsh)) { \
+            return 0; \
+        } \
+        \
+        type##_node_t *node = &__gh_node(hsh, slot); \
+        if (found) { /* replace */ \
+        	__gh_value_free(hsh, node->value); \
+            if (!__gh_value_copy(hsh, node->value, v)) { \
+                return 0; \
+            } \
         } else { /* insert */ \
-            hsh->size++; \
-            if (GH_BUCKET_STATE(hsh->flags, tgt) == GH_BUCKET_EMPTY) hsh->n_occupied++; \
-            if (__gh_key_copy(hsh, hsh->buckets[tgt].key, k) && __gh_value_copy(hsh, hsh->buckets[tgt].value, v)) { \
-                GH_SET_BUCKET_STATE(hsh->flags, tgt, GH_BUCKET_FULL); \
-            } else { \
+            if (!__gh_key_copy(hsh, node->key, k)) { \
                 return 0; \
             } \
+            if (!__gh_value_copy(hsh, node->value, v)) { \
+                __gh_key_free(hsh, node->key); \
+                return 0; \
+            } \
+            __##type##_commit(hsh, slot); \
         } \
         \
         return 1; \
@@ -368,20 +885,48 @@
     \
     int type##_delete(type##_t *hsh, key_t k) { \
         gh_hash_t slot = type##_find_slot(hsh, k); \
-        if (slot == hsh->n_buckets) { \
+        if (slot == __gh_slot_none(hsh)) { \
             return 0; \
         } else { \
-            __gh_key_free(hsh, hsh->buckets[slot].key); \
-            __gh_value_free(hsh, hsh->buckets[slot].value); \
-            GH_SET_BUCKET_STATE(hsh->flags, slot, GH_BUCKET_DELETED); \
-            hsh->size--; \
+            __gh_key_free(hsh, __gh_node(hsh, slot).key); \
+            __gh_value_free(hsh, __gh_node(hsh, slot).value); \
+            __##type##_remove_slot(hsh, slot); \
             return 1; \
         } \
     } \
     \
-    gh_hash_t type##_size(type##_t *hsh) { \
-        return hsh->size; \
+    /* \
+     * initialise dst as a copy of src. with the default (assignment) key/value \
+     * copy the table arrays are duplicated with memcpy; otherwise the copy \
+     * functions are applied to each entry. returns 0 on failure, leaving dst \
+     * empty and needing no dealloc. \
+     */ \
+    int type##_clone(type##_t *dst, type##_t *src) { \
+        gh_hash_t ix; \
+        if (!__##type##_clone_table(dst, src)) return 0; \
+        if (__gh_key_copy_is_raw && __gh_value_copy_is_raw) return 1; \
+        for (ix = 0; ix < __gh_iter_end(src); ix++) { \
+            if (__gh_iter_valid(src, ix)) { \
+                type##_node_t *node = &__gh_node(dst, ix); \
+                if (!__gh_key_copy(dst, node->key, __gh_node(src, ix).key)) break; \
+                if (!__gh_value_copy(dst, node->value, __gh_node(src, ix).value)) { \
+                    __gh_key_free(dst, node->key); \
+                    break; \
+                } \
+            } \
+        } \
+        if (ix == __gh_iter_end(src)) return 1; \
+        while (ix-- > 0) { /* unwind */ \
+            if (__gh_iter_valid(src, ix)) { \
+                __gh_key_free(dst, __gh_node(dst, ix).key); \
+                __gh_value_free(dst, __gh_node(dst, ix).value); \
+            } \
+        } \
+        __##type##_clone_abort(dst); \
+        return 0; \
     } \
+    \
+    __GEN_HASH_INIT_BUILD_PARALLEL(type, key_t, value_t) \
     
 #define GEN_HASH_DECLARE(type, key_t, value_t) \
     GEN_HASH_DECLARE_STORAGE(type, key_t, value_t); \
@@ -391,3 +936,156 @@
     GEN_HASH_DECLARE(type, key_t, value_t); \
     GEN_HASH_INIT(type, key_t, value_t); \
 
+/*
+ * Hash set
+ *
+ * As above, but nodes hold keys only. Configured with the same GEN_HASH_*
+ * options (the GEN_HASH_VALUE_* options are ignored).
+ *
+ * my_set.h:
+ * #include "gen_hash.h"
+ * GEN_HASH_SET_DECLARE(typename, const char *);
+ *
+ * my_set.c:
+ * #include "gen_hash_reset.h"
+ * #define GEN_HASH_HASH_FUNC   hash_djb2
+ * #define GEN_HASH_KEY_CMP     strcmp
+ * #include "gen_hash.h"
+ * GEN_HASH_SET_INIT(typename, const char *);
+ *
+ * The bulk operations modify dst in place; src is left untouched:
+ * union        - add every key in src to dst
+ * intersection - remove from dst every key not in src
+ * difference   - remove from dst every key in src
+ */
+
+#define GEN_HASH_SET_DECLARE_STORAGE(type, key_t) \
+    typedef struct type##_node type##_node_t; \
+    struct type##_node { \
+        key_t           key; \
+    }; \
+    \
+    __GEN_HASH_DECLARE_TABLE(type)
+
+#define GEN_HASH_SET_DECLARE_INTERFACE(type, key_t) \
+    void        type##_init(type##_t *hsh); \
+    void        type##_dealloc(type##_t *hsh); \
+    gh_hash_t   type##_find_slot(type##_t *hsh, key_t k); \
+    int         type##_contains(type##_t *hsh, key_t k); \
+    int         type##_add(type##_t *hsh, key_t k); \
+    int         type##_remove(type##_t *hsh, key_t k); \
+    gh_hash_t   type##_size(type##_t *hsh); \
+    int         type##_clone(type##_t *dst, type##_t *src); \
+    int         type##_union(type##_t *dst, type##_t *src); \
+    void        type##_intersection(type##_t *dst, type##_t *src); \
+    void        type##_difference(type##_t *dst, type##_t *src);
+
+#define GEN_HASH_SET_INIT(type, key_t) \
+    __GEN_HASH_INIT_TABLE(type, key_t) \
+    \
+    void type##_dealloc(type##_t *hsh) { \
+    	gh_hash_t ix = 0; \
+    	for (ix = 0; ix < __gh_iter_end(hsh); ix++) { \
+    		if (__gh_iter_valid(hsh, ix)) { \
+    			__gh_key_free(hsh, __gh_node(hsh, ix).key); \
+    		} \
+    	} \
+    	__gh_free(hsh, hsh->flags); \
+    	__gh_free(hsh, hsh->buckets); \
+    	__gh_filter_free(hsh, hsh->filter); \
+    } \
+    \
+    int type##_add(type##_t *hsh, key_t k) { \
+        int found; \
+        gh_hash_t slot = __##type##_insert_slot(hsh, k, &found); \
+        if (slot == __gh_slot_none(hsh)) { \
+            return 0; \
+        } else if (!found) { \
+            if (!__gh_key_copy(hsh, __gh_node(hsh, slot).key, k)) { \
+                return 0; \
+            } \
+            __##type##_commit(hsh, slot); \
+        } \
+        return 1; \
+    } \
+    \
+    int type##_remove(type##_t *hsh, key_t k) { \
+        gh_hash_t slot = type##_find_slot(hsh, k); \
+        if (slot == __gh_slot_none(hsh)) { \
+            return 0; \
+        } else { \
+            __gh_key_free(hsh, __gh_node(hsh, slot).key); \
+            __##type##_remove_slot(hsh, slot); \
+            return 1; \
+        } \
+    } \
+    \
+    /* as GEN_HASH's clone() */ \
+    int type##_clone(type##_t *dst, type##_t *src) { \
+        gh_hash_t ix; \
+        if (!__##type##_clone_table(dst, src)) return 0; \
+        if (__gh_key_copy_is_raw) return 1; \
+        for (ix = 0; ix < __gh_iter_end(src); ix++) { \
+            if (__gh_iter_valid(src, ix) && !__gh_key_copy(dst, __gh_node(dst, ix).key, __gh_node(src, ix).key)) break; \
+        } \
+        if (ix == __gh_iter_end(src)) return 1; \
+        while (ix-- > 0) { /* unwind */ \
+            if (__gh_iter_valid(src, ix)) __gh_key_free(dst, __gh_node(dst, ix).key); \
+        } \
+        __##type##_clone_abort(dst); \
+        return 0; \
+    } \
+    \
+    int type##_union(type##_t *dst, type##_t *src) { \
+        gh_hash_t ix; \
+        /* grow once up front rather than repeatedly during insertion */ \
+        if (!__gh_is_small(dst) && dst->n_occupied + src->size >= dst->upper_bound) { \
+            if (!__##type##_resize(dst, (dst->size + src->size) / GEN_HASH_MAX_LOAD + 1)) { \
+                return 0; \
+            } \
+        } \
+        for (ix = 0; ix < __gh_iter_end(src); ix++) { \
+            if (__gh_iter_valid(src, ix) && !type##_add(dst, __gh_node(src, ix).key)) { \
+                return 0; \
+            } \
+        } \
+        return 1; \
+    } \
+    \
+    void type##_intersection(type##_t *dst, type##_t *src) { \
+        gh_hash_t ix; \
+        /* iterate backwards; in small mode, removal moves the last entry into the vacated slot */ \
+        for (ix = __gh_iter_end(dst); ix-- > 0;) { \
+            if (__gh_iter_valid(dst, ix) && !type##_contains(src, __gh_node(dst, ix).key)) { \
+                __gh_key_free(dst, __gh_node(dst, ix).key); \
+                __##type##_remove_slot(dst, ix); \
+            } \
+        } \
+    } \
+    \
+    void type##_difference(type##_t *dst, type##_t *src) { \
+        gh_hash_t ix; \
+        if (src->size < dst->size) { /* probe dst once per key in the smaller set */ \
+            for (ix = 0; ix < __gh_iter_end(src); ix++) { \
+                if (__gh_iter_valid(src, ix)) { \
+                    type##_remove(dst, __gh_node(src, ix).key); \
+                } \
+            } \
+        } else { \
+            for (ix = __gh_iter_end(dst); ix-- > 0;) { \
+                if (__gh_iter_valid(dst, ix) && type##_contains(src, __gh_node(dst, ix).key)) { \
+                    __gh_key_free(dst, __gh_node(dst, ix).key); \
+                    __##type##_remove_slot(dst, ix); \
+                } \
+            } \
+        } \
+    } \
+
+#define GEN_HASH_SET_DECLARE(type, key_t) \
+    GEN_HASH_SET_DECLARE_STORAGE(type, key_t); \
+    GEN_HASH_SET_DECLARE_INTERFACE(type, key_t);
+
+#define GEN_HASH_SET(type, key_t) \
+    GEN_HASH_SET_DECLARE(type, key_t); \
+    GEN_HASH_SET_INIT(type, key_t); \
+
@@ -10,6 +10,11 @@
 #undef GEN_HASH_KEY_FREE
 #undef GEN_HASH_VALUE_COPY
 #undef GEN_HASH_VALUE_FREE
+#undef GEN_HASH_INLINE_CAPACITY
+#undef GEN_HASH_FILTER
+#undef GEN_HASH_FILTER_BITS_PER_KEY
+#undef GEN_HASH_PARALLEL_BUILD
+#undef GEN_HASH_PARALLEL_BUILD_MIN
 
 #undef __gh_debug
 #undef __gh_malloc
@@ -18,6 +23,28 @@
 #undef __gh_hash_key
 #undef __gh_key_cmp
 #undef __gh_key_copy
+#undef __gh_key_copy_is_raw
 #undef __gh_key_free
 #undef __gh_value_copy
+#undef __gh_value_copy_is_raw
 #undef __gh_value_free
+#undef __gh_inline_capacity
+#undef __gh_inline_storage
+#undef __gh_inline_nodes
+#undef __gh_is_small
+#undef __gh_slot_none
+#undef __gh_node
+#undef __gh_filter_storage
+#undef __gh_filter_local
+#undef __gh_filter_alloc
+#undef __gh_filter_free
+#undef __gh_filter_reset
+#undef __gh_filter_clear
+#undef __gh_filter_clone
+#undef __gh_filter_replace
+#undef __gh_filter_add
+#undef __gh_filter_test
+#undef __gh_build_parallel_decl
+#undef __GEN_HASH_INIT_BUILD_PARALLEL
+#undef __gh_iter_end
+#undef __gh_iter_valid
@@ -0,0 +1,333 @@
+/*
+ * A bounded cache with LRU (or CLOCK) eviction, built on gen_hash.
+ *
+ * Entries live in a fixed array of `capacity` slots, allocated once by
+ * type_init(). A gen_hash table maps each key to its slot; recency is tracked
+ * intrusively within the slot array (as a doubly-linked list of indices for
+ * LRU, or a single reference bit per slot for CLOCK). Once full, each
+ * insertion of a new key evicts one entry, releasing its key and value via
+ * GEN_HASH_KEY_FREE and GEN_HASH_VALUE_FREE.
+ *
+ * The map is sized by type_init() to hold twice capacity keys, and never
+ * resizes. Evictions and deletes leave tombstones in it; these are cleared by
+ * rehashing the map in place, into a spare flags array allocated alongside
+ * it, at most once every capacity removals. Neither get nor put allocates
+ * (other than via GEN_HASH_KEY_COPY/GEN_HASH_VALUE_COPY), and put is
+ * amortised O(1): the O(n_buckets) rehash is spread over the removals
+ * that preceded it.
+ *
+ * Configured with the same GEN_HASH_* options as gen_hash.h, plus:
+ *
+ * GEN_LRU_CACHE_CLOCK - use the CLOCK approximation of LRU. get() then only
+ * sets a reference bit rather than relinking the entry, at the cost of
+ * slightly less accurate eviction choices.
+ *
+ * Any user-defined memory management / copy functions receive the map's
+ * userdata, i.e. cache->map.userdata.
+ *
+ * my_cache.h:
+ * #include "gen_lru_cache.h"
+ * GEN_LRU_CACHE_DECLARE(typename, const char *, int);
+ *
+ * my_cache.c:
+ * #include "gen_lru_cache_reset.h"
+ * #define GEN_HASH_HASH_FUNC   hash_djb2
+ * #define GEN_HASH_KEY_CMP     strcmp
+ * #define GEN_HASH_KEY_COPY    gen_strcpy
+ * #define GEN_HASH_KEY_FREE    free
+ * #include "gen_lru_cache.h"
+ * GEN_LRU_CACHE_INIT(typename, const char *, int);
+ */
+
+#include "jazlib/gen_hash.h"
+
+#ifndef __JAZLIB__GEN_LRU_CACHE_H__
+#define __JAZLIB__GEN_LRU_CACHE_H__
+    #define GH_LRU_NIL                          ((uint32_t)-1)
+#endif
+
+/*
+ * Configuration
+ * #define these before #include'ing gen_lru_cache.h
+ */
+
+#ifdef GEN_LRU_CACHE_CLOCK
+    #define __gh_lru_entry_fields \
+        unsigned char   referenced;     /* set on access, cleared as the clock hand passes */
+    #define __gh_lru_cache_fields \
+        uint32_t        hand;           /* next slot to be considered for eviction */
+    #define __GEN_LRU_CACHE_INIT_POLICY(type) \
+        static void __##type##_policy_init(type##_t *cache) { \
+            cache->hand = 0; \
+        } \
+        \
+        static void __##type##_touch(type##_t *cache, uint32_t ix) { \
+            cache->entries[ix].referenced = 1; \
+        } \
+        \
+        /* new entries start unreferenced, so one-off insertions are evicted before anything re-used */ \
+        static void __##type##_link(type##_t *cache, uint32_t ix) { \
+            cache->entries[ix].referenced = 0; \
+        } \
+        \
+        static void __##type##_unlink(type##_t *cache, uint32_t ix) { \
+        } \
+        \
+        static void __##type##_relocate(type##_t *cache, uint32_t from, uint32_t to) { \
+            if (cache->hand == from) cache->hand = to; \
+        } \
+        \
+        static uint32_t __##type##_victim(type##_t *cache) { \
+            while (1) { \
+                uint32_t ix = cache->hand; \
+                cache->hand = (ix + 1 == cache->size) ? 0 : ix + 1; \
+                if (!cache->entries[ix].referenced) return ix; \
+                cache->entries[ix].referenced = 0; \
+            } \
+        }
+#else
+    #define __gh_lru_entry_fields \
+        uint32_t        prev;           /* next most recently used slot */ \
+        uint32_t        next;           /* next least recently used slot */
+    #define __gh_lru_cache_fields \
+        uint32_t        head;           /* most recently used slot */ \
+        uint32_t        tail;           /* least recently used slot */
+    #define __GEN_LRU_CACHE_INIT_POLICY(type) \
+        static void __##type##_policy_init(type##_t *cache) { \
+            cache->head = GH_LRU_NIL; \
+            cache->tail = GH_LRU_NIL; \
+        } \
+        \
+        static void __##type##_unlink(type##_t *cache, uint32_t ix) { \
+            type##_entry_t *e = &cache->entries[ix]; \
+            if (e->prev == GH_LRU_NIL) cache->head = e->next; else cache->entries[e->prev].next = e->next; \
+            if (e->next == GH_LRU_NIL) cache->tail = e->prev; else cache->entries[e->next].prev = e->prev; \
+        } \
+        \
+        static void __##type##_link(type##_t *cache, uint32_t ix) { \
+            type##_entry_t *e = &cache->entries[ix]; \
+            e->prev = GH_LRU_NIL; \
+            e->next = cache->head; \
+            if (cache->head != GH_LRU_NIL) cache->entries[cache->head].prev = ix; \
+            cache->head = ix; \
+            if (cache->tail == GH_LRU_NIL) cache->tail = ix; \
+        } \
+        \
+        static void __##type##_touch(type##_t *cache, uint32_t ix) { \
+            if (cache->head != ix) { \
+                __##type##_unlink(cache, ix); \
+                __##type##_link(cache, ix); \
+            } \
+        } \
+        \
+        /* entry has been copied from slot `from` to slot `to`; repoint its neighbours */ \
+        static void __##type##_relocate(type##_t *cache, uint32_t from, uint32_t to) { \
+            type##_entry_t *e = &cache->entries[to]; \
+            if (e->prev == GH_LRU_NIL) cache->head = to; else cache->entries[e->prev].next = to; \
+            if (e->next == GH_LRU_NIL) cache->tail = to; else cache->entries[e->next].prev = to; \
+        } \
+        \
+        static uint32_t __##type##_victim(type##_t *cache) { \
+            uint32_t ix = cache->tail; \
+            __##type##_unlink(cache, ix); \
+            return ix; \
+        }
+#endif
+
+/*
+ * End Configuration
+ */
+
+#define GEN_LRU_CACHE_DECLARE_STORAGE(type, key_t, value_t) \
+    typedef struct type##_map_node type##_map_node_t; \
+    struct type##_map_node { \
+        key_t           key; \
+        uint32_t        entry;          /* index into cache's entries */ \
+    }; \
+    \
+    __GEN_HASH_DECLARE_TABLE(type##_map) \
+    \
+    typedef struct type##_entry type##_entry_t; \
+    struct type##_entry { \
+        key_t           key;            /* alias of key stored in map; owned by the map */ \
+        value_t         value; \
+        __gh_lru_entry_fields \
+    }; \
+    \
+    typedef struct type { \
+        type##_map_t    map;            /* key -> entry index */ \
+        unsigned char   *spare_flags;   /* scratch flags for rehashing map in place */ \
+        type##_entry_t  *entries;       /* fixed array of capacity entries; [0, size) are in use */ \
+        uint32_t        capacity; \
+        uint32_t        size; \
+        __gh_lru_cache_fields \
+    } type##_t;
+
+#define GEN_LRU_CACHE_DECLARE_INTERFACE(type, key_t, value_t) \
+    int         type##_init(type##_t *cache, uint32_t capacity); \
+    void        type##_dealloc(type##_t *cache); \
+    int         type##_contains(type##_t *cache, key_t k); \
+    int         type##_get(type##_t *cache, key_t k, value_t *v); \
+    int         type##_put(type##_t *cache, key_t k, value_t v); \
+    int         type##_delete(type##_t *cache, key_t k); \
+    uint32_t    type##_size(type##_t *cache);
+
+#define GEN_LRU_CACHE_INIT(type, key_t, value_t) \
+    __GEN_HASH_INIT_TABLE(type##_map, key_t) \
+    __GEN_LRU_CACHE_INIT_POLICY(type) \
+    \
+    /* remove the key at map slot from the map, freeing it */ \
+    static void __##type##_unmap(type##_t *cache, gh_hash_t slot) { \
+        type##_map_t *map = &cache->map; \
+        __gh_key_free(map, __gh_node(map, slot).key); \
+        __##type##_map_remove_slot(map, slot); \
+    } \
+    \
+    /* release unlinked, unmapped slot ix, moving the last entry into it so [0, size) stays dense */ \
+    static void __##type##_vacate(type##_t *cache, uint32_t ix) { \
+        uint32_t last = --cache->size; \
+        if (ix != last) { \
+            type##_map_t *map = &cache->map; \
+            cache->entries[ix] = cache->entries[last]; \
+            __gh_node(map, type##_map_find_slot(map, cache->entries[ix].key)).entry = ix; \
+            __##type##_relocate(cache, last, ix); \
+        } \
+    } \
+    \
+    int type##_init(type##_t *cache, uint32_t capacity) { \
+        type##_map_init(&cache->map); \
+        cache->entries = NULL; \
+        cache->spare_flags = NULL; \
+        cache->capacity = capacity; \
+        cache->size = 0; \
+        __##type##_policy_init(cache); \
+        if (capacity > __gh_inline_capacity) { \
+            /* \
+             * size the table up front so it never grows. with room for twice \
+             * capacity keys, at least capacity tombstones accumulate between \
+             * in-place rehashes. \
+             */ \
+            if (!__##type##_map_resize(&cache->map, 2 * capacity / GEN_HASH_MAX_LOAD + 1)) goto fail; \
+            cache->spare_flags = __gh_malloc((&cache->map), sizeof(unsigned char) * ((cache->map.n_buckets >> 2) + 1)); \
+            if (!cache->spare_flags) goto fail; \
+        } \
+        cache->entries = __gh_malloc((&cache->map), sizeof(type##_entry_t) * capacity); \
+        if (!cache->entries) goto fail; \
+        return 1; \
+        \
+    fail: /* release whatever was allocated, leaving a zero-capacity cache that needs no dealloc */ \
+        type##_dealloc(cache); \
+        type##_map_init(&cache->map); \
+        cache->entries = NULL; \
+        cache->spare_flags = NULL; \
+        cache->capacity = 0; \
+        return 0; \
+    } \
+    \
+    void type##_dealloc(type##_t *cache) { \
+        type##_map_t *map = &cache->map; \
+        uint32_t ix; \
+        for (ix = 0; ix < cache->size; ix++) { \
+            __gh_key_free(map, cache->entries[ix].key); \
+            __gh_value_free(map, cache->entries[ix].value); \
+        } \
+        __gh_free(map, map->flags); \
+        __gh_free(map, map->buckets); \
+        __gh_filter_free(map, map->filter); \
+        __gh_free(map, cache->spare_flags); \
+        __gh_free(map, cache->entries); \
+    } \
+    \
+    /* does not affect recency */ \
+    int type##_contains(type##_t *cache, key_t k) { \
+        return type##_map_contains(&cache->map, k); \
+    } \
+    \
+    int type##_get(type##_t *cache, key_t k, value_t *v) { \
+        type##_map_t *map = &cache->map; \
+        gh_hash_t slot = type##_map_find_slot(map, k); \
+        if (slot == __gh_slot_none(map)) { \
+            return 0; \
+        } else { \
+            uint32_t ix = __gh_node(map, slot).entry; \
+            __##type##_touch(cache, ix); \
+            *v = cache->entries[ix].value; \
+            return 1; \
+        } \
+    } \
+    \
+    int type##_put(type##_t *cache, key_t k, value_t v) { \
+        type##_map_t *map = &cache->map; \
+        uint32_t ix; \
+        int found; \
+        \
+        if (cache->capacity == 0) return 0; \
+        \
+        gh_hash_t slot = type##_map_find_slot(map, k); \
+        if (slot != __gh_slot_none(map)) { /* replace */ \
+            ix = __gh_node(map, slot).entry; \
+            __##type##_touch(cache, ix); \
+            __gh_value_free(map, cache->entries[ix].value); \
+            return __gh_value_copy(map, cache->entries[ix].value, v); \
+        } \
+        \
+        if (cache->size == cache->capacity) { /* evict, and reuse the victim's slot */ \
+            ix = __##type##_victim(cache); \
+            __gh_value_free(map, cache->entries[ix].value); \
+            __##type##_unmap(cache, type##_map_find_slot(map, cache->entries[ix].key)); \
+        } else { \
+            ix = cache->size++; \
+        } \
+        \
+        if (cache->spare_flags && map->n_occupied >= map->upper_bound) { /* clear tombstones rather than grow */ \
+            cache->spare_flags = __##type##_map_rehash_in_place(map, cache->spare_flags); \
+        } \
+        \
+        slot = __##type##_map_insert_slot(map, k, &found); \
+        if (slot == __gh_slot_none(map)) { \
+            __##type##_vacate(cache, ix); \
+            return 0; \
+        } \
+        if (!__gh_key_copy(map, __gh_node(map, slot).key, k)) { \
+            __##type##_vacate(cache, ix); \
+            return 0; \
+        } \
+        if (!__gh_value_copy(map, cache->entries[ix].value, v)) { \
+            __gh_key_free(map, __gh_node(map, slot).key); \
+            __##type##_vacate(cache, ix); \
+            return 0; \
+        } \
+        __gh_node(map, slot).entry = ix; \
+        __##type##_map_commit(map, slot); \
+        cache->entries[ix].key = __gh_node(map, slot).key; \
+        __##type##_link(cache, ix); \
+        return 1; \
+    } \
+    \
+    int type##_delete(type##_t *cache, key_t k) { \
+        type##_map_t *map = &cache->map; \
+        gh_hash_t slot = type##_map_find_slot(map, k); \
+        if (slot == __gh_slot_none(map)) { \
+            return 0; \
+        } else { \
+            uint32_t ix = __gh_node(map, slot).entry; \
+            __##type##_unlink(cache, ix); \
+            __gh_value_free(map, cache->entries[ix].value); \
+            __##type##_unmap(cache, slot); \
+            __##type##_vacate(cache, ix); \
+            return 1; \
+        } \
+    } \
+    \
+    uint32_t type##_size(type##_t *cache) { \
+        return cache->size; \
+    } \
+
+#define GEN_LRU_CACHE_DECLARE(type, key_t, value_t) \
+    GEN_LRU_CACHE_DECLARE_STORAGE(type, key_t, value_t); \
+    GEN_LRU_CACHE_DECLARE_INTERFACE(type, key_t, value_t);
+
+#define GEN_LRU_CACHE(type, key_t, value_t) \
+    GEN_LRU_CACHE_DECLARE(type, key_t, value_t); \
+    GEN_LRU_CACHE_INIT(type, key_t, value_t); \
+
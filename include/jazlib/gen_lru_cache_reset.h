@@ -0,0 +1,7 @@
+#include "jazlib/gen_hash_reset.h"
+
+#undef GEN_LRU_CACHE_CLOCK
+
+#undef __gh_lru_entry_fields
+#undef __gh_lru_cache_fields
+#undef __GEN_LRU_CACHE_INIT_POLICY
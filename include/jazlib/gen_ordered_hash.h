@@ -0,0 +1,387 @@
+/*
+ * An insertion-ordered, compact generic hash.
+ *
+ * Modelled on CPython's (3.6+) dict: entries are appended to a dense array in
+ * insertion order, and a separate sparse index of small integers maps hash
+ * slots to positions in that array. Iteration is a linear scan over packed
+ * entries, yielding keys in the order they were first inserted.
+ *
+ * The entry array grows by 1.5x, independently of the index, which is a
+ * power of 2 kept at most 2/3 full. Each entry caches 32 bits of its key's
+ * hash. Per live key this costs 16-24 bytes of entries plus 6-12 bytes of
+ * index for e.g. (const char *, int), against 23-46 bytes of buckets for
+ * gen_hash at its default maximum load of 0.7.
+ *
+ * Deleting an entry leaves a hole in the dense array; holes are squeezed out
+ * (preserving order) whenever the entry array or index is next rebuilt.
+ *
+ * my_ohash.h:
+ * #include "gen_ordered_hash.h"
+ * GEN_ORDERED_HASH_DECLARE(typename, const char *, int);
+ *
+ * my_ohash.c:
+ * #include "gen_ordered_hash_reset.h"
+ * #define GEN_ORDERED_HASH_HASH_FUNC   hash_djb2
+ * #define GEN_ORDERED_HASH_KEY_CMP     strcmp
+ * #define GEN_ORDERED_HASH_KEY_COPY    gen_strcpy
+ * #define GEN_ORDERED_HASH_KEY_FREE    free
+ * #include "gen_ordered_hash.h"
+ * GEN_ORDERED_HASH_INIT(typename, const char *, int);
+ *
+ * Iteration:
+ * gh_iter_t iter = 0;
+ * const char *k; int v;
+ * while (typename_next(&hsh, &iter, &k, &v)) ...
+ */
+
+#ifndef __JAZLIB__GEN_ORDERED_HASH_H__
+#define __JAZLIB__GEN_ORDERED_HASH_H__
+    #include <string.h>
+
+    #include "jazlib/gen_hash_common.h"
+
+    #define GOH_INDEX_EMPTY                     (-1)
+    #define GOH_INDEX_DELETED                   (-2)
+
+    #define GOH_ENTRY_DEAD(dead, ix)            ((dead[(ix)>>3]>>((ix)&7))&1)
+    #define GOH_SET_ENTRY_DEAD(dead, ix)        (dead[(ix)>>3]|=(1<<((ix)&7)))
+
+    #define GOH_DEBUG_PRINT(hsh)                printf("i=%lu e=%lu cap=%lu sz=%lu\n", (unsigned long)(hsh)->n_index, (unsigned long)(hsh)->n_entries, (unsigned long)(hsh)->capacity, (unsigned long)(hsh)->size)
+#endif
+
+/*
+ * Configuration
+ * #define these before #include'ing gen_ordered_hash.h
+ */
+
+/* malloc function (for internal data structures only, not keys/values), default is malloc() */
+#ifdef GEN_ORDERED_HASH_MALLOC
+    #define __goh_malloc(hsh,sz) (GEN_ORDERED_HASH_MALLOC(hsh->userdata, sz))
+#else
+    #include <stdlib.h>
+    #define __goh_malloc(hsh,sz) malloc(sz)
+#endif
+
+/* realloc function (for internal data structures only, not keys/values), default is realloc() */
+#ifdef GEN_ORDERED_HASH_REALLOC
+    #define __goh_realloc(hsh,ptr,sz) (GEN_ORDERED_HASH_REALLOC(hsh->userdata, ptr, sz))
+#else
+    #include <stdlib.h>
+    #define __goh_realloc(hsh,ptr,sz) realloc(ptr, sz)
+#endif
+
+/* free function (for internal data structures only, not keys/values), default is free() */
+#ifdef GEN_ORDERED_HASH_FREE
+    #define __goh_free(hsh,ptr) (GEN_ORDERED_HASH_FREE(hsh->userdata, ptr))
+#else
+    #include <stdlib.h>
+    #define __goh_free(hsh,ptr) free(ptr)
+#endif
+
+/* minimum number of slots in the sparse index; must be a power of 2 */
+#ifndef GEN_ORDERED_HASH_MIN_INDEX
+    #define GEN_ORDERED_HASH_MIN_INDEX 8
+#endif
+
+/*
+ * hash function - takes a key as input, returns hash code.
+ * if undefined, key is simply cast to gh_hash_t
+ */
+#ifdef GEN_ORDERED_HASH_HASH_FUNC
+    #define __goh_hash_key(k) (GEN_ORDERED_HASH_HASH_FUNC(k))
+#else
+    #define __goh_hash_key(k) ((gh_hash_t)k)
+#endif
+
+/*
+ * function used to compare two keys.
+ * should return 0 on equality, non-zero otherwise
+ * if undefined, "==" is used
+ */
+#ifdef GEN_ORDERED_HASH_KEY_CMP
+    #define __goh_key_cmp(l,r) (GEN_ORDERED_HASH_KEY_CMP(l,r) == 0)
+#else
+    #define __goh_key_cmp(l,r) (l == r)
+#endif
+
+/*
+ * function used to copy keys.
+ * function receives object to copy and pointer to location to store the copy
+ * should return 1 on success, 0 on failure.
+ * if undefined, simple assignment ("=") is used.
+ */
+#ifdef GEN_ORDERED_HASH_KEY_COPY
+    #define __goh_key_copy(hsh,target,value) (GEN_ORDERED_HASH_KEY_COPY(hsh->userdata, value, &target))
+#else
+    #define __goh_key_copy(hsh,target,value) ((target = value), 1)
+#endif
+
+#ifdef GEN_ORDERED_HASH_KEY_FREE
+    #define __goh_key_free(hsh,k) (GEN_ORDERED_HASH_KEY_FREE(hsh->userdata, k))
+#else
+    #define __goh_key_free(hsh,k)
+#endif
+
+/*
+ * function used to copy values.
+ * function receives object to copy and pointer to location to store the copy
+ * should return 1 on success, 0 on failure.
+ * if undefined, simple assignment ("=") is used.
+ */
+#ifdef GEN_ORDERED_HASH_VALUE_COPY
+    #define __goh_value_copy(hsh,target,value) (GEN_ORDERED_HASH_VALUE_COPY(hsh->userdata, value, &target))
+#else
+    #define __goh_value_copy(hsh,target,value) ((target = value), 1)
+#endif
+
+#ifdef GEN_ORDERED_HASH_VALUE_FREE
+    #define __goh_value_free(hsh,v) (GEN_ORDERED_HASH_VALUE_FREE(hsh->userdata, v))
+#else
+    #define __goh_value_free(hsh,v)
+#endif
+
+/*
+ * End Configuration
+ */
+
+#define GEN_ORDERED_HASH_DECLARE_STORAGE(type, key_t, value_t) \
+    typedef struct type##_entry type##_entry_t; \
+    struct type##_entry { \
+        key_t           key; \
+        value_t         value; \
+        uint32_t        hash;           /* cached hash code, saves rehashing on rebuild and most failed key comparisons */ \
+    }; \
+    \
+    typedef struct type { \
+        gh_hash_t       n_index;        /* # of slots in sparse index (always a power of 2) */ \
+        gh_hash_t       n_entries;      /* # of entries used in dense array, including deleted (and so # of index slots in use) */ \
+        gh_hash_t       capacity;       /* # of entries allocated in dense array */ \
+        gh_hash_t       size;           /* # of K/V pairs in the hash (i.e. live entries) */ \
+        int32_t         *index;         /* sparse index; each slot is an entry position, or GOH_INDEX_EMPTY/DELETED */ \
+        unsigned char   *dead;          /* packed bit array marking deleted entries */ \
+        type##_entry_t  *entries;       /* dense, insertion-ordered entries */ \
+        void            *userdata;      /* custom userdata. mainly useful for passing context into user-defined memory mgmt functions */ \
+    } type##_t;
+
+#define GEN_ORDERED_HASH_DECLARE_INTERFACE(type, key_t, value_t) \
+    void        type##_init(type##_t *hsh); \
+    void        type##_dealloc(type##_t *hsh); \
+    int         type##_contains(type##_t *hsh, key_t k); \
+    int         type##_read(type##_t *hsh, key_t k, value_t *v); \
+    int         type##_put(type##_t *hsh, key_t k, value_t v); \
+    int         type##_delete(type##_t *hsh, key_t k); \
+    gh_hash_t   type##_size(type##_t *hsh); \
+    int         type##_next(type##_t *hsh, gh_iter_t *iter, key_t *k, value_t *v);
+
+#define GEN_ORDERED_HASH_INIT(type, key_t, value_t) \
+    /* \
+     * find the entry for key k with hash code hc. returns its position in the \
+     * entry array, or -1 if not found. if islot is non-NULL it receives the \
+     * index slot referencing the entry or, if not found, the slot into which \
+     * a new entry for k should be placed. \
+     */ \
+    static int32_t __##type##_lookup(type##_t *hsh, key_t k, uint32_t hc, gh_hash_t *islot) { \
+        gh_hash_t mask      = hsh->n_index - 1; \
+        gh_hash_t i         = hc & mask; \
+        gh_hash_t perturb   = hc; \
+        gh_hash_t free_slot = hsh->n_index; \
+        while (1) { \
+            int32_t ix = hsh->index[i]; \
+            if (ix == GOH_INDEX_EMPTY) { \
+                if (islot) *islot = (free_slot == hsh->n_index) ? i : free_slot; \
+                return -1; \
+            } else if (ix == GOH_INDEX_DELETED) { \
+                if (free_slot == hsh->n_index) free_slot = i; \
+            } else if (hsh->entries[ix].hash == hc && __goh_key_cmp(hsh->entries[ix].key, k)) { \
+                if (islot) *islot = i; \
+                return ix; \
+            } \
+            perturb >>= 5; \
+            i = (i * 5 + perturb + 1) & mask; \
+        } \
+    } \
+    \
+    /* \
+     * grow the entry array to capacity (if larger), then squeeze out dead \
+     * entries and rebuild the index with n_index slots. everything that can \
+     * fail happens before hsh is modified, so on failure hsh is untouched \
+     * (bar a possibly larger entry allocation). \
+     */ \
+    static int __##type##_rebuild(type##_t *hsh, gh_hash_t capacity, gh_hash_t n_index) { \
+        if (capacity > hsh->capacity) { \
+            type##_entry_t *entries = __goh_realloc(hsh, hsh->entries, sizeof(type##_entry_t) * capacity); \
+            if (!entries) return 0; \
+            hsh->entries = entries; \
+            unsigned char *dead = __goh_realloc(hsh, hsh->dead, (capacity >> 3) + 1); \
+            if (!dead) return 0; \
+            hsh->dead = dead; \
+        } else { \
+            capacity = hsh->capacity; \
+        } \
+        \
+        int32_t *index = hsh->index; \
+        if (n_index != hsh->n_index) { \
+            index = __goh_malloc(hsh, sizeof(int32_t) * n_index); \
+            if (!index) return 0; \
+        } \
+        \
+        gh_hash_t src, dst = 0; \
+        for (src = 0; src < hsh->n_entries; src++) { \
+            if (!GOH_ENTRY_DEAD(hsh->dead, src)) { \
+                if (src != dst) hsh->entries[dst] = hsh->entries[src]; \
+                dst++; \
+            } \
+        } \
+        memset(hsh->dead, 0, (capacity >> 3) + 1); \
+        \
+        memset(index, 0xff, sizeof(int32_t) * n_index); /* GOH_INDEX_EMPTY */ \
+        gh_hash_t mask = n_index - 1; \
+        for (src = 0; src < dst; src++) { \
+            gh_hash_t hc        = hsh->entries[src].hash; \
+            gh_hash_t i         = hc & mask; \
+            gh_hash_t perturb   = hc; \
+            while (index[i] != GOH_INDEX_EMPTY) { \
+                perturb >>= 5; \
+                i = (i * 5 + perturb + 1) & mask; \
+            } \
+            index[i] = (int32_t)src; \
+        } \
+        \
+        if (index != hsh->index) __goh_free(hsh, hsh->index); \
+        hsh->index = index; \
+        hsh->n_index = n_index; \
+        hsh->capacity = capacity; \
+        hsh->n_entries = dst; \
+        return 1; \
+    } \
+    \
+    /* \
+     * make room for one more entry. dead entries are reclaimed in place once \
+     * they make up 1/8 of the entry array; otherwise the entry array grows by \
+     * 1.5x when full and the index doubles when 2/3 full. \
+     */ \
+    static int __##type##_grow(type##_t *hsh) { \
+        gh_hash_t dead      = hsh->n_entries - hsh->size; \
+        int compact         = dead > 0 && dead * 8 >= hsh->n_entries; \
+        gh_hash_t capacity  = hsh->capacity; \
+        gh_hash_t n_index   = GEN_ORDERED_HASH_MIN_INDEX; \
+        if (hsh->n_entries == hsh->capacity && !compact) { \
+            capacity = capacity ? capacity + (capacity >> 1) + 1 : (GEN_ORDERED_HASH_MIN_INDEX * 2) / 3; \
+        } \
+        while ((n_index * 2) / 3 < hsh->size + 1) n_index <<= 1; \
+        if (hsh->n_entries + 1 > (hsh->n_index * 2) / 3 && !compact && n_index <= hsh->n_index) { \
+            n_index = hsh->n_index << 1; \
+        } \
+        return __##type##_rebuild(hsh, capacity, n_index); \
+    } \
+    \
+    void type##_init(type##_t *hsh) { \
+        memset(hsh, 0, sizeof(type##_t)); \
+    } \
+    \
+    void type##_dealloc(type##_t *hsh) { \
+        gh_hash_t ix; \
+        for (ix = 0; ix < hsh->n_entries; ix++) { \
+            if (!GOH_ENTRY_DEAD(hsh->dead, ix)) { \
+                __goh_key_free(hsh, hsh->entries[ix].key); \
+                __goh_value_free(hsh, hsh->entries[ix].value); \
+            } \
+        } \
+        __goh_free(hsh, hsh->index); \
+        __goh_free(hsh, hsh->dead); \
+        __goh_free(hsh, hsh->entries); \
+    } \
+    \
+    int type##_contains(type##_t *hsh, key_t k) { \
+        return hsh->n_index && __##type##_lookup(hsh, k, (uint32_t)__goh_hash_key(k), NULL) >= 0; \
+    } \
+    \
+    int type##_read(type##_t *hsh, key_t k, value_t *v) { \
+        if (!hsh->n_index) return 0; \
+        int32_t ix = __##type##_lookup(hsh, k, (uint32_t)__goh_hash_key(k), NULL); \
+        if (ix < 0) { \
+            return 0; \
+        } else { \
+            *v = hsh->entries[ix].value; \
+            return 1; \
+        } \
+    } \
+    \
+    int type##_put(type##_t *hsh, key_t k, value_t v) { \
+        uint32_t hc = (uint32_t)__goh_hash_key(k); \
+        gh_hash_t islot; \
+        int32_t ix = -1; \
+        \
+        if (hsh->n_index) { \
+            ix = __##type##_lookup(hsh, k, hc, &islot); \
+        } \
+        \
+        if (ix >= 0) { /* replace */ \
+            __goh_value_free(hsh, hsh->entries[ix].value); \
+            return __goh_value_copy(hsh, hsh->entries[ix].value, v); \
+        } \
+        \
+        if (hsh->n_entries == hsh->capacity || hsh->n_entries + 1 > (hsh->n_index * 2) / 3) { \
+            if (!__##type##_grow(hsh)) return 0; \
+            __##type##_lookup(hsh, k, hc, &islot); \
+        } \
+        \
+        type##_entry_t *entry = &hsh->entries[hsh->n_entries]; \
+        entry->hash = hc; \
+        if (!__goh_key_copy(hsh, entry->key, k)) { \
+            return 0; \
+        } \
+        if (!__goh_value_copy(hsh, entry->value, v)) { \
+            __goh_key_free(hsh, entry->key); \
+            return 0; \
+        } \
+        hsh->index[islot] = (int32_t)hsh->n_entries++; \
+        hsh->size++; \
+        return 1; \
+    } \
+    \
+    int type##_delete(type##_t *hsh, key_t k) { \
+        if (!hsh->n_index) return 0; \
+        gh_hash_t islot; \
+        int32_t ix = __##type##_lookup(hsh, k, (uint32_t)__goh_hash_key(k), &islot); \
+        if (ix < 0) { \
+            return 0; \
+        } else { \
+            __goh_key_free(hsh, hsh->entries[ix].key); \
+            __goh_value_free(hsh, hsh->entries[ix].value); \
+            hsh->index[islot] = GOH_INDEX_DELETED; \
+            GOH_SET_ENTRY_DEAD(hsh->dead, ix); \
+            hsh->size--; \
+            return 1; \
+        } \
+    } \
+    \
+    gh_hash_t type##_size(type##_t *hsh) { \
+        return hsh->size; \
+    } \
+    \
+    /* \
+     * fetch the next entry in insertion order. *iter should be initialised to 0. \
+     * returns 1 and writes to *k and *v (either may be NULL) if an entry was found, \
+     * 0 when iteration is complete. \
+     */ \
+    int type##_next(type##_t *hsh, gh_iter_t *iter, key_t *k, value_t *v) { \
+        while (*iter < hsh->n_entries) { \
+            gh_iter_t ix = (*iter)++; \
+            if (!GOH_ENTRY_DEAD(hsh->dead, ix)) { \
+                if (k) *k = hsh->entries[ix].key; \
+                if (v) *v = hsh->entries[ix].value; \
+                return 1; \
+            } \
+        } \
+        return 0; \
+    } \
+
+#define GEN_ORDERED_HASH_DECLARE(type, key_t, value_t) \
+    GEN_ORDERED_HASH_DECLARE_STORAGE(type, key_t, value_t); \
+    GEN_ORDERED_HASH_DECLARE_INTERFACE(type, key_t, value_t);
+
+#define GEN_ORDERED_HASH(type, key_t, value_t) \
+    GEN_ORDERED_HASH_DECLARE(type, key_t, value_t); \
+    GEN_ORDERED_HASH_INIT(type, key_t, value_t); \
+
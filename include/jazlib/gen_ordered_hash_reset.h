@@ -0,0 +1,20 @@
+#undef GEN_ORDERED_HASH_MALLOC
+#undef GEN_ORDERED_HASH_REALLOC
+#undef GEN_ORDERED_HASH_FREE
+#undef GEN_ORDERED_HASH_MIN_INDEX
+#undef GEN_ORDERED_HASH_HASH_FUNC
+#undef GEN_ORDERED_HASH_KEY_CMP
+#undef GEN_ORDERED_HASH_KEY_COPY
+#undef GEN_ORDERED_HASH_KEY_FREE
+#undef GEN_ORDERED_HASH_VALUE_COPY
+#undef GEN_ORDERED_HASH_VALUE_FREE
+
+#undef __goh_malloc
+#undef __goh_realloc
+#undef __goh_free
+#undef __goh_hash_key
+#undef __goh_key_cmp
+#undef __goh_key_copy
+#undef __goh_key_free
+#undef __goh_value_copy
+#undef __goh_value_free
@@ -0,0 +1,261 @@
+/*
+ * Generic Segmented Vector
+ *
+ * Same interface as gen_vector.h, but elements live in fixed-size chunks
+ * reached through a chunk directory rather than a single contiguous array.
+ * Growing never copies existing elements (only the directory of chunk
+ * pointers is ever reallocated), so large vectors grow without a transient
+ * doubling of memory, and push, pop and set leave the addresses of other
+ * elements unchanged. delete is the exception: it shifts every later
+ * element down one index, so a pointer from type_ptr() to any element after
+ * the deleted one then refers to that element's successor.
+ *
+ * my_segvector.h
+ * #include "gen_segvector.h"
+ * GEN_SEGVECTOR_DECLARE(my_segvector, const char *);
+ *
+ * my_segvector.c
+ * #include "gen_segvector_reset.h"
+ * #define GEN_SEGVECTOR_VALUE_CMP   strcmp
+ * #define GEN_SEGVECTOR_VALUE_COPY  gen_strcpy
+ * #define GEN_SEGVECTOR_VALUE_FREE  free
+ * #include "gen_segvector.h"
+ * GEN_SEGVECTOR_INIT(my_segvector, const char *);
+ *
+ * Chunk-at-a-time iteration:
+ * int c, i, len;
+ * for (c = 0; c < my_segvector_chunk_count(&vec); c++) {
+ *     const char **chunk = my_segvector_chunk(&vec, c, &len);
+ *     for (i = 0; i < len; i++) ...
+ * }
+ */
+
+#ifndef __JAZLIB__GEN_SEGVECTOR_H__
+#define __JAZLIB__GEN_SEGVECTOR_H__
+    #include <string.h>
+    #include <assert.h>
+#endif
+
+/*
+ * Configuration
+ * #define these before #include'ing gen_segvector.h
+ */
+
+/* malloc function (for internal data structures only, not values), default is malloc() */
+#ifdef GEN_SEGVECTOR_MALLOC
+    #define __gsv_malloc(sz) (GEN_SEGVECTOR_MALLOC(sz))
+#else
+    #include <stdlib.h>
+    #define __gsv_malloc(sz) malloc(sz)
+#endif
+
+/* realloc function (for internal data structures only, not values), default is realloc() */
+#ifdef GEN_SEGVECTOR_REALLOC
+    #define __gsv_realloc(ptr, sz) (GEN_SEGVECTOR_REALLOC(ptr, sz))
+#else
+    #include <stdlib.h>
+    #define __gsv_realloc(ptr, sz) realloc(ptr, sz)
+#endif
+
+/* free function (for internal data structures only, not values), default is free() */
+#ifdef GEN_SEGVECTOR_FREE
+    #define __gsv_free(ptr) (GEN_SEGVECTOR_FREE(ptr))
+#else
+    #include <stdlib.h>
+    #define __gsv_free(ptr) free(ptr)
+#endif
+
+/* log2 of the number of elements per chunk, default is 10 (1024 elements) */
+#ifndef GEN_SEGVECTOR_CHUNK_BITS
+    #define GEN_SEGVECTOR_CHUNK_BITS 10
+#endif
+
+/* initial number of slots in the chunk directory; doubled as required */
+#ifndef GEN_SEGVECTOR_DIRECTORY_SIZE
+    #define GEN_SEGVECTOR_DIRECTORY_SIZE 8
+#endif
+
+#define __gsv_chunk_size                (1 << GEN_SEGVECTOR_CHUNK_BITS)
+#define __gsv_chunk_ix(ix)              ((ix) >> GEN_SEGVECTOR_CHUNK_BITS)
+#define __gsv_chunk_offset(ix)          ((ix) & (__gsv_chunk_size - 1))
+#define __gsv_at(vec, ix)               ((vec)->chunks[__gsv_chunk_ix(ix)][__gsv_chunk_offset(ix)])
+
+/*
+ * function used to compare values.
+ * should return 0 on equality, non-zero otherwise
+ * if undefined, "==" is used
+ */
+#ifdef GEN_SEGVECTOR_VALUE_CMP
+    #define __gsv_is_equal(l,r) (GEN_SEGVECTOR_VALUE_CMP(l,r) == 0)
+#else
+    #define __gsv_is_equal(l,r) (l == r)
+#endif
+
+/*
+ * function used to copy values.
+ * function receives object to copy and pointer to location to store the copy
+ * should return 1 on success, 0 on failure.
+ * if undefined, simple assignment ("=") is used.
+ */
+#ifdef GEN_SEGVECTOR_VALUE_COPY
+    #define __gsv_value_copy(target,value) (GEN_SEGVECTOR_VALUE_COPY(value, &target))
+#else
+    #define __gsv_value_copy(target,value) ((target = value), 1)
+#endif
+
+#ifdef GEN_SEGVECTOR_VALUE_FREE
+    #define __gsv_value_free(k) (GEN_SEGVECTOR_VALUE_FREE(k))
+#else
+    #define __gsv_value_free(k)
+#endif
+
+/*
+ * End Configuration
+ */
+
+#define GEN_SEGVECTOR_DECLARE(type, value_t) \
+    typedef struct type { \
+        int                 size; \
+        int                 n_chunks;       /* # of chunks allocated */ \
+        int                 dir_capacity;   /* # of slots in chunk directory */ \
+        value_t             **chunks;       /* chunk directory */ \
+    } type##_t; \
+    \
+    int         type##_init(type##_t *vec); \
+    void        type##_clear(type##_t *vec); \
+    int         type##_size(type##_t *vec); \
+    int         type##_contains(type##_t *vec, value_t value); \
+    int         type##_find(type##_t *vec, value_t value); \
+    int         type##_push(type##_t *vec, value_t value); \
+    value_t     type##_pop(type##_t *vec); \
+    int         type##_set(type##_t *vec, int ix, value_t value); \
+    int         type##_delete(type##_t *vec, int ix); \
+    value_t     type##_get(type##_t *vec, int ix); \
+    value_t *   type##_ptr(type##_t *vec, int ix); \
+    int         type##_chunk_count(type##_t *vec); \
+    value_t *   type##_chunk(type##_t *vec, int chunk_ix, int *len);
+
+#define GEN_SEGVECTOR_INIT(type, value_t) \
+    /* ensure chunks exist to hold indices [0, ix] */ \
+    static int __##type##_reserve(type##_t *vec, int ix) { \
+        int need = __gsv_chunk_ix(ix) + 1; \
+        if (need > vec->dir_capacity) { \
+            int new_dir_capacity = vec->dir_capacity ? vec->dir_capacity : GEN_SEGVECTOR_DIRECTORY_SIZE; \
+            while (new_dir_capacity < need) new_dir_capacity *= 2; \
+            value_t **new_chunks = __gsv_realloc(vec->chunks, sizeof(value_t*) * new_dir_capacity); \
+            if (!new_chunks) return 0; \
+            vec->chunks = new_chunks; \
+            vec->dir_capacity = new_dir_capacity; \
+        } \
+        while (vec->n_chunks < need) { \
+            value_t *chunk = __gsv_malloc(sizeof(value_t) * __gsv_chunk_size); \
+            if (!chunk) return 0; \
+            memset(chunk, 0, sizeof(value_t) * __gsv_chunk_size); \
+            vec->chunks[vec->n_chunks++] = chunk; \
+        } \
+        return 1; \
+    } \
+    \
+    /* release chunks lying wholly beyond the end of the vector, keeping one spare \
+     * to avoid thrashing when size oscillates around a chunk boundary */ \
+    static void __##type##_trim(type##_t *vec) { \
+        int keep = (vec->size ? __gsv_chunk_ix(vec->size - 1) + 1 : 0) + 1; \
+        while (vec->n_chunks > keep) { \
+            __gsv_free(vec->chunks[--vec->n_chunks]); \
+        } \
+    } \
+    \
+    int type##_init(type##_t *vec) { \
+        vec->size = 0; \
+        vec->n_chunks = 0; \
+        vec->dir_capacity = 0; \
+        vec->chunks = NULL; \
+        return 1; \
+    } \
+    \
+    void type##_clear(type##_t *vec) { \
+        int i; \
+        for (i = 0; i < vec->size; i++) { \
+            __gsv_value_free(__gsv_at(vec, i)); \
+        } \
+        for (i = 0; i < vec->n_chunks; i++) { \
+            __gsv_free(vec->chunks[i]); \
+        } \
+        __gsv_free(vec->chunks); \
+        type##_init(vec); \
+    } \
+    \
+    int type##_size(type##_t *vec) { \
+        return vec->size; \
+    } \
+    \
+    int type##_contains(type##_t *vec, value_t value) { \
+        return type##_find(vec, value) >= 0; \
+    } \
+    \
+    int type##_find(type##_t *vec, value_t value) { \
+        int c, i, len; \
+        for (c = 0; c < type##_chunk_count(vec); c++) { \
+            value_t *chunk = type##_chunk(vec, c, &len); \
+            for (i = 0; i < len; i++) { \
+                if (__gsv_is_equal(chunk[i], value)) return (c << GEN_SEGVECTOR_CHUNK_BITS) + i; \
+            } \
+        } \
+        return -1; \
+    } \
+    \
+    int type##_push(type##_t *vec, value_t value) { \
+        return type##_set(vec, vec->size, value); \
+    } \
+    \
+    value_t type##_pop(type##_t *vec) { \
+        value_t v = __gsv_at(vec, vec->size - 1); \
+        type##_delete(vec, vec->size - 1); \
+        return v; \
+    } \
+    \
+    int type##_set(type##_t *vec, int ix, value_t value) { \
+        if (!__##type##_reserve(vec, ix)) return 0; \
+        if (!__gsv_value_copy(__gsv_at(vec, ix), value)) return 0; \
+        if (vec->size < ix + 1) vec->size = ix + 1; \
+        return 1; \
+    } \
+    \
+    /* shifts later elements down; pointers to them no longer track them */ \
+    int type##_delete(type##_t *vec, int ix) { \
+        if (vec->size == 0 || ix >= vec->size) return 0; \
+        __gsv_value_free(__gsv_at(vec, ix)); \
+        int i; \
+        for (i = ix; i < vec->size - 1; i++) { \
+            __gsv_at(vec, i) = __gsv_at(vec, i + 1); \
+        } \
+        vec->size--; \
+        __##type##_trim(vec); \
+        return 1; \
+    } \
+    \
+    value_t type##_get(type##_t *vec, int ix) { \
+        return __gsv_at(vec, ix); \
+    } \
+    \
+    /* valid until ix is popped or cleared, or an earlier index is deleted */ \
+    value_t * type##_ptr(type##_t *vec, int ix) { \
+        return &__gsv_at(vec, ix); \
+    } \
+    \
+    int type##_chunk_count(type##_t *vec) { \
+        return vec->size ? __gsv_chunk_ix(vec->size - 1) + 1 : 0; \
+    } \
+    \
+    value_t * type##_chunk(type##_t *vec, int chunk_ix, int *len) { \
+        int start = chunk_ix << GEN_SEGVECTOR_CHUNK_BITS; \
+        int remaining = vec->size - start; \
+        *len = remaining < __gsv_chunk_size ? remaining : __gsv_chunk_size; \
+        return vec->chunks[chunk_ix]; \
+    } \
+
+
+#define GEN_SEGVECTOR(type, value_t) \
+    GEN_SEGVECTOR_DECLARE(type, value_t); \
+    GEN_SEGVECTOR_INIT(type, value_t); \
+
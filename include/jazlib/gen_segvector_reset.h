@@ -0,0 +1,19 @@
+#undef GEN_SEGVECTOR_MALLOC
+#undef GEN_SEGVECTOR_REALLOC
+#undef GEN_SEGVECTOR_FREE
+#undef GEN_SEGVECTOR_CHUNK_BITS
+#undef GEN_SEGVECTOR_DIRECTORY_SIZE
+#undef GEN_SEGVECTOR_VALUE_CMP
+#undef GEN_SEGVECTOR_VALUE_COPY
+#undef GEN_SEGVECTOR_VALUE_FREE
+
+#undef __gsv_malloc
+#undef __gsv_realloc
+#undef __gsv_free
+#undef __gsv_chunk_size
+#undef __gsv_chunk_ix
+#undef __gsv_chunk_offset
+#undef __gsv_at
+#undef __gsv_is_equal
+#undef __gsv_value_copy
+#undef __gsv_value_free
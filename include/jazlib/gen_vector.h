@@ -12,6 +12,12 @@
  * #define GEN_VECTOR_VALUE_FREE  free
  * #include "gen_vector.h"
  * GEN_VECTOR_INIT(my_vector, const char *);
+ *
+ * Small vectors can avoid the heap entirely by reserving inline storage
+ * (see GEN_VECTOR_INLINE_CAPACITY below):
+ * #define GEN_VECTOR_INLINE_CAPACITY 8
+ * #include "gen_vector.h"
+ * GEN_VECTOR(my_small_vector, int);
  */
 
 #ifndef __JAZLIB__GEN_VECTOR_H__
@@ -70,6 +76,32 @@
     #define GEN_VECTOR_SHRINK_THRESHOLD 0.3
 #endif
 
+/*
+ * number of elements to store inline, inside the vector struct itself.
+ * vectors whose capacity never exceeds this don't touch the heap at all;
+ * storage spills to the heap once the vector outgrows it, and moves back
+ * inline if it later shrinks far enough.
+ * if undefined, all storage is heap-allocated.
+ *
+ * must be defined identically wherever GEN_VECTOR_DECLARE and GEN_VECTOR_INIT
+ * are expanded for a given type, as it changes the struct layout.
+ */
+#ifdef GEN_VECTOR_INLINE_CAPACITY
+    #define __gv_inline_capacity            (GEN_VECTOR_INLINE_CAPACITY)
+    #define __gv_inline_storage(value_t)    value_t inline_values[GEN_VECTOR_INLINE_CAPACITY];
+    #define __gv_values(vec)                ((vec)->values ? (vec)->values : (vec)->inline_values)
+    #define __gv_inline_zero(vec)           memset((vec)->inline_values, 0, sizeof((vec)->inline_values))
+    #define __gv_spill(vec, dst)            memcpy(dst, (vec)->inline_values, sizeof((vec)->inline_values))
+    #define __gv_unspill(vec)               memcpy((vec)->inline_values, (vec)->values, sizeof((vec)->values[0]) * (vec)->size)
+#else
+    #define __gv_inline_capacity            0
+    #define __gv_inline_storage(value_t)
+    #define __gv_values(vec)                ((vec)->values)
+    #define __gv_inline_zero(vec)
+    #define __gv_spill(vec, dst)
+    #define __gv_unspill(vec)
+#endif
+
 /*
  * function used to compare values.
  * should return 0 on equality, non-zero otherwise
@@ -110,7 +142,8 @@
         int                 size; \
         int                 capacity; \
         int                 shrink_threshold; \
-        value_t             *values; \
+        value_t             *values;        /* heap storage, or NULL when using inline storage */ \
+        __gv_inline_storage(value_t) \
     } type##_t; \
     \
     int         type##_init(type##_t *vec); \
@@ -132,21 +165,24 @@
     \
     int type##_init(type##_t *vec) { \
         vec->values = NULL; \
+        vec->size = 0; \
         type##_clear(vec); \
         return 1; \
     } \
     \
     void type##_clear(type##_t *vec) { \
+        int i; \
+        for (i = 0; i < vec->size; i++) { \
+            __gv_value_free(__gv_values(vec)[i]); \
+        } \
         if (vec->values) { \
-            int i; \
-            for (i = 0; i < vec->size; i++) { \
-                __gv_value_free(vec->values[ix]); \
-            } \
             __gv_free(vec->values); \
             vec->values = NULL; \
         } \
+        __gv_inline_zero(vec); \
         vec->size = 0; \
-        vec->capacity = 0; \
+        vec->capacity = __gv_inline_capacity; \
+        vec->shrink_threshold = 0; \
     } \
     \
     int type##_size(type##_t *vec) { \
@@ -160,7 +196,7 @@
     int type##_find(type##_t *vec, value_t value) { \
         int i; \
         for (i = 0; i < vec->size; i++) { \
-            if (__gv_is_equal(vec->values[i], value)) return i; \
+            if (__gv_is_equal(__gv_values(vec)[i], value)) return i; \
         } \
         return -1; \
     } \
@@ -170,7 +206,7 @@
     } \
     \
     value_t type##_pop(type##_t *vec) { \
-        value_t v = vec->values[vec->size - 1]; \
+        value_t v = __gv_values(vec)[vec->size - 1]; \
         type##_delete(vec, vec->size - 1); \
         return v; \
     } \
@@ -178,45 +214,63 @@
     int type##_set(type##_t *vec, int ix, value_t value) { \
         size_t new_capacity = vec->capacity; \
         if (vec->capacity < ix + 1) { \
-            int s_ix = type##_n_sizes - 1; \
-            while (s_ix >= 0) { \
-                if (type##_sizes[s_ix] <= vec->capacity) { \
-                    new_capacity = type##_sizes[s_ix + 1]; \
-                    break; \
-                } \
-                s_ix--; \
-            } \
-        } else if (vec->capacity > type##_sizes[1] && vec->size < vec->shrink_threshold) { \
             int s_ix = 1; \
             while (s_ix < type##_n_sizes) { \
-                if (type##_sizes[s_ix] > vec->size) { \
+                if (type##_sizes[s_ix] > vec->capacity && type##_sizes[s_ix] > ix) { \
                     new_capacity = type##_sizes[s_ix]; \
                     break; \
                 } \
                 s_ix++; \
             } \
+        } else if ((vec->capacity > type##_sizes[1] || (__gv_inline_capacity && vec->values)) && vec->size < vec->shrink_threshold) { \
+            /* shrink to the smallest capacity holding both the current elements and ix */ \
+            if (ix < __gv_inline_capacity && vec->size <= __gv_inline_capacity) { \
+                new_capacity = __gv_inline_capacity; \
+            } else { \
+                int s_ix = 1; \
+                while (s_ix < type##_n_sizes) { \
+                    if (type##_sizes[s_ix] > vec->size && type##_sizes[s_ix] > ix) { \
+                        new_capacity = type##_sizes[s_ix]; \
+                        break; \
+                    } \
+                    s_ix++; \
+                } \
+            } \
         } \
         if (new_capacity != vec->capacity) { \
-            vec->values = __gv_realloc(vec->values, sizeof(value_t) * new_capacity); \
-            if (!vec->values) return 0; \
+            if (new_capacity <= __gv_inline_capacity) { /* shrinking back into inline storage */ \
+                __gv_unspill(vec); \
+                __gv_free(vec->values); \
+                vec->values = NULL; \
+            } else if (!vec->values) { /* spilling out of inline storage (or first allocation) */ \
+                value_t *new_values = __gv_malloc(sizeof(value_t) * new_capacity); \
+                if (!new_values) return 0; \
+                __gv_spill(vec, new_values); \
+                vec->values = new_values; \
+            } else { \
+                value_t *new_values = __gv_realloc(vec->values, sizeof(value_t) * new_capacity); \
+                if (!new_values) return 0; \
+                vec->values = new_values; \
+            } \
             if (new_capacity > vec->capacity) { \
-                memset(vec->values + vec->capacity, 0, (new_capacity - vec->capacity) * sizeof(value_t)); \
+                memset(__gv_values(vec) + vec->capacity, 0, (new_capacity - vec->capacity) * sizeof(value_t)); \
             } \
             vec->capacity = new_capacity; \
             vec->shrink_threshold = (int)((float)new_capacity * GEN_VECTOR_SHRINK_THRESHOLD); \
         } \
-        if (!__gv_value_copy(vec->values[ix], value)) return 0; \
+        if (!__gv_value_copy(__gv_values(vec)[ix], value)) return 0; \
         if (vec->size < ix + 1) vec->size = ix + 1; \
         return 1; \
     } \
     \
     int type##_delete(type##_t *vec, int ix) { \
+        value_t *values = __gv_values(vec); \
         if (vec->size == 0 || ix >= vec->size) return 0; \
-        __gv_value_free(vec->values[ix]); \
+        __gv_value_free(values[ix]); \
         if (ix < vec->size - 1) { \
             int i; \
             for (i = ix; i < vec->size - 1; i++) { \
-                vec->values[i] = vec->values[i + 1]; \
+                values[i] = values[i + 1]; \
             } \
         } \
         vec->size--; \
@@ -224,7 +278,7 @@
     } \
     \
     value_t type##_get(type##_t *vec, int ix) { \
-        return vec->values[ix]; \
+        return __gv_values(vec)[ix]; \
     } \
 
 
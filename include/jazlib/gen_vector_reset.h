@@ -3,6 +3,7 @@
 #undef GEN_VECTOR_FREE
 #undef GEN_VECTOR_SIZES
 #undef GEN_VECTOR_SHRINK_THRESHOLD
+#undef GEN_VECTOR_INLINE_CAPACITY
 #undef GEN_VECTOR_VALUE_CMP
 #undef GEN_VECTOR_VALUE_COPY
 #undef GEN_VECTOR_VALUE_FREE
@@ -14,3 +15,9 @@
 #undef __gv_is_equal
 #undef __gv_value_copy
 #undef __gv_value_free
+#undef __gv_inline_capacity
+#undef __gv_inline_storage
+#undef __gv_values
+#undef __gv_inline_zero
+#undef __gv_spill
+#undef __gv_unspill
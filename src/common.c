@@ -27,9 +27,52 @@ int gen_strcpy(void *context, const char *v, const char **t) {
     if (!v) *t = NULL;
     else {
         char *out = malloc(strlen(v) + 1);
-        if (!*out) return 0;
+        if (!out) return 0;
         strcpy(out, v);
         *t = out;
     }
     return 1;
 }
+
+static gh_hash_t hash_djb2_len(const char *key, size_t len) {
+    const unsigned char *str = (const unsigned char *)key;
+    gh_hash_t hash = 5381;
+    while (len--)
+        hash = ((hash << 5) + hash) + *str++;
+    return hash ? hash : 1; /* 0 is reserved for "not cached" */
+}
+
+gen_strview_t gen_strview(const char *ptr, size_t len) {
+    gen_strview_t sv = { ptr, len, 0 };
+    return sv;
+}
+
+gen_strview_t gen_strview_hashed(const char *ptr, size_t len) {
+    gen_strview_t sv = { ptr, len, hash_djb2_len(ptr, len) };
+    return sv;
+}
+
+gh_hash_t hash_strview(gen_strview_t key) {
+    return key.hash ? key.hash : hash_djb2_len(key.ptr, key.len);
+}
+
+int gen_strview_cmp(gen_strview_t l, gen_strview_t r) {
+    if (l.hash && r.hash && l.hash != r.hash) return 1;
+    if (l.len != r.len) return 1;
+    return memcmp(l.ptr, r.ptr, l.len);
+}
+
+int gen_strview_copy(void *context, gen_strview_t v, gen_strview_t *t) {
+    char *out = malloc(v.len + 1);
+    if (!out) return 0;
+    memcpy(out, v.ptr, v.len);
+    out[v.len] = '\0';
+    t->ptr = out;
+    t->len = v.len;
+    t->hash = hash_strview(v);
+    return 1;
+}
+
+void gen_strview_free(void *context, gen_strview_t v) {
+    free((void *)v.ptr);
+}
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_PARALLEL_BUILD
+#define GEN_HASH_HASH_FUNC      hash_djb2
+#define GEN_HASH_KEY_CMP        strcmp
+#include "jazlib/gen_hash.h"
+GEN_HASH(hash, const char *, int);
+
+#define COUNT   500000
+#define THREADS 4
+
+void fail(const char *msg) {
+    printf("error: %s\n", msg);
+    exit(1);
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+
+    const char **keys = malloc(sizeof(const char *) * COUNT);
+    int *values = malloc(sizeof(int) * COUNT);
+    int i, v;
+
+    /* every tenth key repeats an earlier one; the later value must win */
+    for (i = 0; i < COUNT; i++) {
+        char *key = malloc(16);
+        sprintf(key, "key%d", (i % 10 == 9) ? i / 2 : i);
+        keys[i] = key;
+        values[i] = i;
+    }
+
+    hash_t seq, par;
+    double t0;
+
+    hash_init(&seq);
+    t0 = now();
+    for (i = 0; i < COUNT; i++) {
+        if (!hash_put(&seq, keys[i], values[i])) fail("put");
+    }
+    printf("sequential put: %.3fs\n", now() - t0);
+
+    hash_init(&par);
+    hash_put(&par, "existing", -1);
+    t0 = now();
+    if (!hash_build_parallel(&par, keys, values, COUNT, THREADS)) fail("build_parallel");
+    printf("build_parallel: %.3fs\n", now() - t0);
+    GH_DEBUG_PRINT(&par);
+
+    if (par.size != seq.size + 1) fail("size");
+    for (i = 0; i < COUNT; i++) {
+        int expected;
+        if (!hash_read(&seq, keys[i], &expected)) fail("sequential read");
+        if (!hash_read(&par, keys[i], &v) || v != expected) fail("read");
+    }
+    if (!hash_read(&par, "existing", &v) || v != -1) fail("existing key");
+
+    /* table must remain fully usable afterwards */
+    for (i = 0; i < COUNT; i += 3) {
+        if (hash_contains(&par, keys[i]) && !hash_delete(&par, keys[i])) fail("delete");
+    }
+    for (i = 0; i < COUNT; i += 3) {
+        if (hash_contains(&par, keys[i])) fail("contains after delete");
+    }
+
+    hash_dealloc(&seq);
+    hash_dealloc(&par);
+    for (i = 0; i < COUNT; i++) {
+        free((void *)keys[i]);
+    }
+    free(keys);
+    free(values);
+
+    printf("ok\n");
+
+    return 0;
+
+}
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+#include "jazlib/gen_filter.h"
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_FILTER
+#define GEN_HASH_HASH_FUNC      hash_djb2
+#define GEN_HASH_KEY_CMP        strcmp
+#define GEN_HASH_KEY_COPY       gen_strcpy
+#define GEN_HASH_KEY_FREE(ctx, k) free((void *)k)
+#include "jazlib/gen_hash.h"
+GEN_HASH(hash, const char *, int);
+
+#define COUNT   200000
+
+void fail(const char *msg) {
+    printf("error: %s\n", msg);
+    exit(1);
+}
+
+void test_standalone() {
+    size_t sz = gh_filter_size(COUNT, GH_FILTER_DEFAULT_BITS_PER_KEY);
+    gh_filter_t f;
+    gh_filter_init(&f, malloc(sz), sz);
+
+    gh_hash_t i;
+    for (i = 0; i < COUNT; i++) {
+        gh_filter_add(&f, i);
+    }
+    for (i = 0; i < COUNT; i++) {
+        if (!gh_filter_test(&f, i)) fail("false negative");
+    }
+
+    unsigned long fp = 0;
+    for (i = COUNT; i < COUNT * 2; i++) {
+        if (gh_filter_test(&f, i)) fp++;
+    }
+    printf("filter bytes=%lu false positive rate=%.3f%%\n", (unsigned long)sz, 100.0 * fp / COUNT);
+    if (fp > COUNT / 20) fail("false positive rate too high");
+
+    if ((uintptr_t)f.words % GH_FILTER_ALIGN != 0) fail("filter blocks not aligned");
+    free(f.storage);
+}
+
+void test_hash() {
+    hash_t hsh;
+    hash_init(&hsh);
+
+    char key[32];
+    int i, v;
+
+    for (i = 0; i < COUNT; i++) {
+        sprintf(key, "key%d", i);
+        if (!hash_put(&hsh, key, i)) fail("put");
+    }
+
+    /* delete half, then churn enough to force resizes that rebuild the filter */
+    for (i = 0; i < COUNT; i += 2) {
+        sprintf(key, "key%d", i);
+        if (!hash_delete(&hsh, key)) fail("delete");
+    }
+    for (i = COUNT; i < COUNT * 2; i += 2) {
+        sprintf(key, "key%d", i);
+        if (!hash_put(&hsh, key, i)) fail("put");
+    }
+
+    /* the clone must carry its own copy of the filter */
+    hash_t copy;
+    if (!hash_clone(&copy, &hsh)) fail("clone");
+    if ((uintptr_t)hsh.filter.words % GH_FILTER_ALIGN != 0 || (uintptr_t)copy.filter.words % GH_FILTER_ALIGN != 0) fail("filter blocks not aligned");
+    hash_dealloc(&hsh);
+
+    for (i = 0; i < COUNT * 2; i++) {
+        sprintf(key, "key%d", i);
+        int expected = (i < COUNT) ? (i % 2 == 1) : (i % 2 == 0);
+        if (hash_read(&copy, key, &v) != expected) fail("read");
+        if (expected && v != i) fail("value");
+        if (hash_contains(&copy, key) != expected) fail("contains");
+    }
+
+    hash_dealloc(&copy);
+    printf("hash ok\n");
+}
+
+int main(int argc, char *argv[]) {
+
+    test_standalone();
+    test_hash();
+
+    return 0;
+
+}
@@ -20,6 +20,38 @@
 #include "jazlib/gen_hash.h"
 GEN_HASH(hash, const char *, const char *);
 
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_INLINE_CAPACITY 4
+#include "jazlib/gen_hash.h"
+GEN_HASH(small_hash, long, long);
+
+void str_free(void *context, const char *v) {
+    free((void *)v);
+}
+
+int fail_malloc = 0;
+
+void *test_malloc(void *context, size_t sz) {
+    return fail_malloc ? NULL : malloc(sz);
+}
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_HASH_FUNC      hash_djb2
+#define GEN_HASH_KEY_CMP        strcmp
+#define GEN_HASH_KEY_COPY       gen_strcpy
+#define GEN_HASH_KEY_FREE       str_free
+#define GEN_HASH_MALLOC         test_malloc
+#include "jazlib/gen_hash.h"
+GEN_HASH(str_hash, const char *, long);
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_HASH_FUNC      hash_strview
+#define GEN_HASH_KEY_CMP        gen_strview_cmp
+#define GEN_HASH_KEY_COPY       gen_strview_copy
+#define GEN_HASH_KEY_FREE       gen_strview_free
+#include "jazlib/gen_hash.h"
+GEN_HASH(sv_hash, gen_strview_t, long);
+
 typedef struct hash_test {
     char    key[16];
     char    value[16];
@@ -55,8 +87,145 @@ void check(hash_t *hsh) {
     }
 }
 
+void test_small_hash() {
+    small_hash_t hsh;
+    small_hash_init(&hsh);
+    
+    long i, v;
+    for (i = 0; i < 4; i++) {
+        small_hash_put(&hsh, i, i * 10);
+    }
+    small_hash_put(&hsh, 2, 200);
+    small_hash_delete(&hsh, 0);
+    small_hash_put(&hsh, 0, 0);
+    
+    if (hsh.n_buckets != 0 || hsh.size != 4) {
+        printf("small hash error: expected inline storage (b=%lu sz=%lu)\n", (unsigned long)hsh.n_buckets, (unsigned long)hsh.size);
+        exit(1);
+    }
+    
+    for (i = 4; i < 100; i++) {
+        small_hash_put(&hsh, i, i * 10);
+    }
+    
+    if (hsh.n_buckets == 0 || hsh.size != 100) {
+        printf("small hash error: expected promotion (b=%lu sz=%lu)\n", (unsigned long)hsh.n_buckets, (unsigned long)hsh.size);
+        exit(1);
+    }
+    
+    for (i = 0; i < 100; i++) {
+        if (!small_hash_read(&hsh, i, &v) || v != (i == 2 ? 200 : i * 10)) {
+            printf("small hash read error (k=%ld)\n", i);
+            exit(1);
+        }
+    }
+    
+    small_hash_dealloc(&hsh);
+    
+    printf("small hash ok\n");
+}
+
+void test_clone() {
+    small_hash_t s, sc;
+    str_hash_t h, hc;
+    char key[32];
+    long i, v;
+
+    small_hash_init(&s);
+    for (i = 0; i < 3; i++) small_hash_put(&s, i, i);
+    if (!small_hash_clone(&sc, &s) || sc.n_buckets != 0 || sc.size != 3) {
+        printf("clone error: inline\n");
+        exit(1);
+    }
+    small_hash_put(&sc, 1, 100);
+    if (!small_hash_read(&s, 1, &v) || v != 1) {
+        printf("clone error: inline copy is shared\n");
+        exit(1);
+    }
+    small_hash_dealloc(&s);
+    small_hash_dealloc(&sc);
+
+    str_hash_init(&h);
+    for (i = 0; i < 1000; i++) {
+        sprintf(key, "k%ld", i);
+        str_hash_put(&h, key, i);
+    }
+    str_hash_delete(&h, "k0");
+    fail_malloc = 1;
+    if (str_hash_clone(&hc, &h) || hc.size != 0 || hc.n_buckets != 0 || hc.buckets != NULL) {
+        printf("clone error: failed clone not left empty\n");
+        exit(1);
+    }
+    fail_malloc = 0;
+    if (!str_hash_put(&hc, "x", 1) || !str_hash_read(&hc, "x", &v) || v != 1) {
+        printf("clone error: failed clone not usable\n");
+        exit(1);
+    }
+    str_hash_dealloc(&hc);
+    if (!str_hash_clone(&hc, &h) || hc.size != h.size) {
+        printf("clone error: copied keys\n");
+        exit(1);
+    }
+    str_hash_dealloc(&h);
+    for (i = 1; i < 1000; i++) {
+        sprintf(key, "k%ld", i);
+        if (!str_hash_read(&hc, key, &v) || v != i) {
+            printf("clone error: copied keys (k=%s)\n", key);
+            exit(1);
+        }
+    }
+    if (str_hash_contains(&hc, "k0")) {
+        printf("clone error: deleted key present\n");
+        exit(1);
+    }
+    str_hash_dealloc(&hc);
+
+    printf("clone ok\n");
+}
+
+void test_strview() {
+    /* keys are slices of one buffer, with no terminators between them */
+    const char *buf = "getsetdelgetx";
+    sv_hash_t hsh;
+    long v;
+
+    sv_hash_init(&hsh);
+    sv_hash_put(&hsh, gen_strview(buf, 3), 1);
+    sv_hash_put(&hsh, gen_strview(buf + 3, 3), 2);
+    sv_hash_put(&hsh, gen_strview_hashed(buf + 6, 3), 3);
+
+    if (hsh.size != 3
+        || !sv_hash_read(&hsh, gen_strview(buf + 9, 3), &v) || v != 1
+        || !sv_hash_read(&hsh, gen_strview_hashed("set", 3), &v) || v != 2
+        || !sv_hash_contains(&hsh, gen_strview("del", 3))
+        || sv_hash_contains(&hsh, gen_strview(buf + 9, 4))
+        || sv_hash_contains(&hsh, gen_strview(buf, 2))) {
+        printf("strview error\n");
+        exit(1);
+    }
+
+    sv_hash_put(&hsh, gen_strview(buf + 9, 3), 4);
+    if (hsh.size != 3 || !sv_hash_read(&hsh, gen_strview("get", 3), &v) || v != 4) {
+        printf("strview error: overwrite\n");
+        exit(1);
+    }
+
+    if (!sv_hash_delete(&hsh, gen_strview("del", 3)) || hsh.size != 2) {
+        printf("strview error: delete\n");
+        exit(1);
+    }
+
+    sv_hash_dealloc(&hsh);
+
+    printf("strview ok\n");
+}
+
 int main(int argc, char *argv[]) {
     
+    test_small_hash();
+    test_clone();
+    test_strview();
+    
     srand(time(NULL));
     
     int i;
@@ -114,6 +283,15 @@ int main(int argc, char *argv[]) {
         check(&hsh);
     }
     
+    hash_t copy;
+    if (!hash_clone(&copy, &hsh)) {
+        printf("clone error\n");
+        exit(1);
+    }
+    hash_dealloc(&hsh);
+    check(&copy);
+    hash_dealloc(&copy);
+    
     printf("ops: %lu\n", ops);
     
     return 0;
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+
+#include "jazlib/gen_hash_reset.h"
+#include "jazlib/gen_hash.h"
+GEN_HASH_SET(set, long);
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_INLINE_CAPACITY 4
+#include "jazlib/gen_hash.h"
+GEN_HASH_SET(small_set, long);
+
+#define COUNT   10000
+
+void fail(const char *msg) {
+    printf("error: %s\n", msg);
+    exit(1);
+}
+
+/* a = multiples of 2 below COUNT, b = multiples of 3 below COUNT */
+void fill(set_t *a, set_t *b) {
+    long i;
+    set_init(a);
+    set_init(b);
+    for (i = 0; i < COUNT; i++) {
+        if (i % 2 == 0 && !set_add(a, i)) fail("add");
+        if (i % 3 == 0 && !set_add(b, i)) fail("add");
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    set_t a, b;
+    long i;
+
+    fill(&a, &b);
+    printf("a size=%lu b size=%lu\n", (unsigned long)a.size, (unsigned long)b.size);
+    if (set_add(&a, 0) != 1 || a.size != (COUNT + 1) / 2) fail("duplicate add changed size");
+
+    set_union(&a, &b);
+    printf("union size=%lu\n", (unsigned long)a.size);
+    for (i = 0; i < COUNT; i++) {
+        if (set_contains(&a, i) != (i % 2 == 0 || i % 3 == 0)) fail("union");
+    }
+    set_dealloc(&a);
+    set_dealloc(&b);
+
+    fill(&a, &b);
+    set_intersection(&a, &b);
+    printf("intersection size=%lu\n", (unsigned long)a.size);
+    for (i = 0; i < COUNT; i++) {
+        if (set_contains(&a, i) != (i % 6 == 0)) fail("intersection");
+    }
+    set_dealloc(&a);
+    set_dealloc(&b);
+
+    fill(&a, &b);
+    set_t c;
+    if (!set_clone(&c, &a) || c.size != a.size) fail("clone");
+    set_dealloc(&a);
+    for (i = 0; i < COUNT; i++) {
+        if (set_contains(&c, i) != (i % 2 == 0)) fail("clone contents");
+    }
+    set_dealloc(&c);
+    set_dealloc(&b);
+
+    fill(&a, &b);
+    set_difference(&a, &b);
+    printf("difference size=%lu\n", (unsigned long)a.size);
+    for (i = 0; i < COUNT; i++) {
+        if (set_contains(&a, i) != (i % 2 == 0 && i % 3 != 0)) fail("difference");
+    }
+    set_dealloc(&a);
+    set_dealloc(&b);
+
+    small_set_t s, t;
+    small_set_init(&s);
+    small_set_init(&t);
+    for (i = 0; i < 5; i++) {
+        if (i < 4) small_set_add(&s, i);
+        small_set_add(&t, i * 2);
+    }
+    small_set_intersection(&s, &t);
+    if (s.n_buckets != 0 || s.size != 2 || !small_set_contains(&s, 0) || !small_set_contains(&s, 2)) fail("small intersection");
+    small_set_union(&s, &t);
+    if (s.n_buckets == 0 || s.size != 5 || !small_set_contains(&s, 8)) fail("small union");
+    if (!small_set_remove(&s, 8) || small_set_remove(&s, 8) || s.size != 4) fail("small remove");
+    small_set_dealloc(&s);
+    small_set_dealloc(&t);
+
+    printf("ok\n");
+
+    return 0;
+
+}
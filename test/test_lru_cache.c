@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+
+#include "jazlib/gen_lru_cache_reset.h"
+#define GEN_HASH_HASH_FUNC      hash_djb2
+#define GEN_HASH_KEY_CMP        strcmp
+#define GEN_HASH_KEY_COPY       gen_strcpy
+#define GEN_HASH_KEY_FREE(ctx, k) free((void *)k)
+#include "jazlib/gen_lru_cache.h"
+GEN_LRU_CACHE(lru, const char *, int);
+
+unsigned long n_allocs = 0;
+long fail_at = -1;      /* index of the allocation to fail, or -1 */
+
+void *counting_malloc(void *ctx, size_t sz) {
+    return (n_allocs++ == fail_at) ? NULL : malloc(sz);
+}
+
+void *counting_realloc(void *ctx, void *ptr, size_t sz) {
+    return (n_allocs++ == fail_at) ? NULL : realloc(ptr, sz);
+}
+
+#include "jazlib/gen_lru_cache_reset.h"
+#define GEN_LRU_CACHE_CLOCK
+#define GEN_HASH_MALLOC         counting_malloc
+#define GEN_HASH_REALLOC        counting_realloc
+#include "jazlib/gen_lru_cache.h"
+GEN_LRU_CACHE(clock_cache, long, long);
+
+#define CAPACITY    100
+#define COUNT       100000
+
+void fail(const char *msg) {
+    printf("error: %s\n", msg);
+    exit(1);
+}
+
+void test_lru() {
+    lru_t cache;
+    char key[32];
+    int i, v;
+
+    if (!lru_init(&cache, CAPACITY)) fail("init");
+
+    for (i = 0; i < COUNT; i++) {
+        sprintf(key, "key%d", i);
+        if (!lru_put(&cache, key, i)) fail("put");
+        if (cache.size > CAPACITY) fail("capacity exceeded");
+        /* keep key0 hot; it must never be evicted */
+        if (!lru_get(&cache, "key0", &v) || v != 0) fail("hot key evicted");
+    }
+
+    /* the most recent CAPACITY - 1 keys, plus key0, should be present */
+    for (i = 1; i < COUNT; i++) {
+        sprintf(key, "key%d", i);
+        if (lru_contains(&cache, key) != (i >= COUNT - CAPACITY + 1)) fail("lru order");
+    }
+
+    sprintf(key, "key%d", COUNT - 1);
+    if (!lru_delete(&cache, key) || lru_contains(&cache, key) || cache.size != CAPACITY - 1) fail("delete");
+    if (!lru_put(&cache, "new", -1) || cache.size != CAPACITY) fail("put after delete");
+    if (!lru_get(&cache, "new", &v) || v != -1) fail("get after delete");
+
+    lru_dealloc(&cache);
+    printf("lru ok\n");
+}
+
+void test_clock() {
+    clock_cache_t cache;
+    long i, v;
+
+    if (!clock_cache_init(&cache, CAPACITY)) fail("init");
+    gh_hash_t n_buckets = cache.map.n_buckets;
+    n_allocs = 0;
+
+    for (i = 0; i < COUNT; i++) {
+        if (!clock_cache_put(&cache, i, i * 2)) fail("put");
+        if (cache.size > CAPACITY) fail("capacity exceeded");
+        if (!clock_cache_get(&cache, 0, &v) || v != 0) fail("hot key evicted");
+        if (i % 7 == 0 && i > 0 && !clock_cache_delete(&cache, i - 1)) fail("delete");
+    }
+
+    /* evictions and deletes must not grow the map or allocate */
+    if (cache.map.n_buckets != n_buckets || n_allocs != 0) fail("map grew");
+
+    for (i = COUNT - CAPACITY / 2; i < COUNT; i++) {
+        int deleted = (i + 1) % 7 == 0;
+        if (clock_cache_get(&cache, i, &v) == deleted || (!deleted && v != i * 2)) fail("recent key evicted");
+    }
+
+    clock_cache_dealloc(&cache);
+    printf("clock ok\n");
+}
+
+/* a failed init must release everything it allocated (checked under a leak checker) */
+void test_failed_init() {
+    clock_cache_t cache;
+    unsigned long needed;
+
+    n_allocs = 0;
+    if (!clock_cache_init(&cache, CAPACITY)) fail("init");
+    clock_cache_dealloc(&cache);
+    needed = n_allocs;
+
+    for (fail_at = 0; fail_at < (long)needed; fail_at++) {
+        n_allocs = 0;
+        if (clock_cache_init(&cache, CAPACITY)) fail("expected init to fail");
+        if (cache.capacity != 0 || cache.entries != NULL || cache.map.buckets != NULL || clock_cache_put(&cache, 1, 1)) fail("failed init not left empty");
+    }
+    fail_at = -1;
+    printf("failed init ok\n");
+}
+
+int main(int argc, char *argv[]) {
+
+    test_lru();
+    test_clock();
+    test_failed_init();
+
+    return 0;
+
+}
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+
+#include "jazlib/gen_ordered_hash_reset.h"
+#define GEN_ORDERED_HASH_HASH_FUNC      hash_djb2
+#define GEN_ORDERED_HASH_KEY_CMP        strcmp
+#define GEN_ORDERED_HASH_KEY_COPY       gen_strcpy
+#define GEN_ORDERED_HASH_KEY_FREE(ctx, k) free((void *)k)
+#include "jazlib/gen_ordered_hash.h"
+GEN_ORDERED_HASH(ohash, const char *, int);
+
+int fail_realloc = 0;
+
+void *test_realloc(void *ctx, void *ptr, size_t sz) {
+    return fail_realloc ? NULL : realloc(ptr, sz);
+}
+
+#include "jazlib/gen_ordered_hash_reset.h"
+#define GEN_ORDERED_HASH_REALLOC        test_realloc
+#include "jazlib/gen_ordered_hash.h"
+GEN_ORDERED_HASH(ohash_long, long, long);
+
+#include "jazlib/gen_ordered_hash_reset.h"
+#define GEN_ORDERED_HASH_HASH_FUNC      hash_djb2
+#define GEN_ORDERED_HASH_KEY_CMP        strcmp
+#include "jazlib/gen_ordered_hash.h"
+GEN_ORDERED_HASH(ohash_plain, const char *, int);
+
+#include "jazlib/gen_hash_reset.h"
+#define GEN_HASH_HASH_FUNC              hash_djb2
+#define GEN_HASH_KEY_CMP                strcmp
+#include "jazlib/gen_hash.h"
+GEN_HASH(hash, const char *, int);
+
+#define COUNT   100000
+
+void fail(const char *msg) {
+    printf("error: %s\n", msg);
+    exit(1);
+}
+
+/* a failed resize must leave the hash untouched */
+void test_failed_resize() {
+    ohash_long_t hsh;
+    gh_iter_t iter = 0;
+    long i, n, k, v, expected = 0;
+
+    /* fill the entry array, then delete too few entries to compact, forcing the next put to grow it */
+    ohash_long_init(&hsh);
+    for (n = 0; hsh.capacity < 16 || hsh.n_entries < hsh.capacity; n++) {
+        if (!ohash_long_put(&hsh, n, n)) fail("put");
+    }
+    ohash_long_delete(&hsh, 1);
+
+    fail_realloc = 1;
+    if (ohash_long_put(&hsh, n, n)) fail("expected put to fail");
+    fail_realloc = 0;
+
+    if (hsh.size != n - 1) fail("size after failed resize");
+    while (ohash_long_next(&hsh, &iter, &k, &v)) {
+        if (expected == 1) expected++;
+        if (k != expected || v != expected) fail("iteration after failed resize");
+        expected++;
+    }
+    if (expected != n) fail("iteration count after failed resize");
+    for (i = 0; i < n; i++) {
+        if (ohash_long_read(&hsh, i, &v) != (i != 1)) fail("read after failed resize");
+    }
+
+    if (!ohash_long_put(&hsh, n, n) || !ohash_long_read(&hsh, n, &v) || v != n) fail("put after failed resize");
+    ohash_long_dealloc(&hsh);
+}
+
+/* memory footprint, averaged over table sizes, must be below gen_hash's for the same keys and values */
+void test_footprint() {
+    ohash_plain_t o;
+    hash_t h;
+    static char keys[200000][12];
+    double o_total = 0, h_total = 0;
+    int i;
+
+    ohash_plain_init(&o);
+    hash_init(&h);
+    for (i = 0; i < 200000; i++) {
+        sprintf(keys[i], "key%d", i);
+        if (!ohash_plain_put(&o, keys[i], i) || !hash_put(&h, keys[i], i)) fail("put");
+        if (i % 101 == 0) {
+            o_total += o.capacity * sizeof(ohash_plain_entry_t) + o.n_index * sizeof(int32_t) + (o.capacity >> 3) + 1;
+            h_total += h.n_buckets * sizeof(hash_node_t) + (h.n_buckets >> 2) + 1;
+        }
+    }
+    printf("footprint relative to gen_hash: %.3f\n", o_total / h_total);
+    if (o_total >= h_total) fail("footprint");
+
+    ohash_plain_dealloc(&o);
+    hash_dealloc(&h);
+}
+
+int main(int argc, char *argv[]) {
+
+    test_failed_resize();
+    test_footprint();
+
+    ohash_t hsh;
+    ohash_init(&hsh);
+
+    char key[32];
+    int i, v;
+
+    for (i = 0; i < COUNT; i++) {
+        sprintf(key, "key%d", i);
+        if (!ohash_put(&hsh, key, i)) fail("put");
+    }
+    GOH_DEBUG_PRINT(&hsh);
+
+    /* delete every odd key, then overwrite every even one; order must be unaffected */
+    for (i = 1; i < COUNT; i += 2) {
+        sprintf(key, "key%d", i);
+        if (!ohash_delete(&hsh, key)) fail("delete");
+    }
+    for (i = 0; i < COUNT; i += 2) {
+        sprintf(key, "key%d", i);
+        if (!ohash_put(&hsh, key, i * 2)) fail("replace");
+    }
+    GOH_DEBUG_PRINT(&hsh);
+
+    if (hsh.size != COUNT / 2) fail("size");
+
+    /* re-adding a deleted key appends it at the end */
+    if (!ohash_put(&hsh, "key1", -1)) fail("put");
+
+    gh_iter_t iter = 0;
+    const char *k;
+    int expected = 0;
+    while (ohash_next(&hsh, &iter, &k, &v)) {
+        if (expected < COUNT) {
+            sprintf(key, "key%d", expected);
+            if (strcmp(k, key) != 0 || v != expected * 2) fail("iteration order");
+            expected += 2;
+        } else {
+            if (strcmp(k, "key1") != 0 || v != -1) fail("iteration order (re-added key)");
+            expected++;
+        }
+    }
+    if (expected != COUNT + 1) fail("iteration count");
+
+    for (i = 0; i < COUNT; i++) {
+        sprintf(key, "key%d", i);
+        int found = ohash_read(&hsh, key, &v);
+        if (found != (i % 2 == 0 || i == 1)) fail("read");
+    }
+
+    ohash_dealloc(&hsh);
+
+    printf("ok\n");
+
+    return 0;
+
+}
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <assert.h>
+
+#include "jazlib/common.h"
+
+#include "jazlib/gen_segvector_reset.h"
+#define GEN_SEGVECTOR_CHUNK_BITS 4
+#include "jazlib/gen_segvector.h"
+GEN_SEGVECTOR(segvector, int);
+
+#define COUNT   1000
+
+int main(int argc, char *argv[]) {
+
+    segvector_t vec;
+    segvector_init(&vec);
+
+    printf("segvector initialised\n");
+    printf("segvector size=%d\n", vec.size);
+    printf("segvector chunks=%d\n", vec.n_chunks);
+
+    int i;
+    for (i = 0; i < COUNT; i++) {
+        segvector_push(&vec, i);
+    }
+
+    int *first = segvector_ptr(&vec, 0);
+
+    for (i = COUNT; i < COUNT * 4; i++) {
+        segvector_push(&vec, i);
+    }
+
+    printf("segvector size=%d\n", vec.size);
+    printf("segvector chunks=%d\n", vec.n_chunks);
+
+    if (first != segvector_ptr(&vec, 0)) {
+        printf("address of element 0 moved\n");
+        exit(1);
+    }
+
+    for (i = 0; i < COUNT * 4; i++) {
+        if (segvector_get(&vec, i) != i) {
+            printf("get error (ix=%d)\n", i);
+            exit(1);
+        }
+    }
+
+    long sum = 0, expected = 0;
+    int c, len;
+    for (c = 0; c < segvector_chunk_count(&vec); c++) {
+        int *chunk = segvector_chunk(&vec, c, &len);
+        for (i = 0; i < len; i++) sum += chunk[i];
+    }
+    for (i = 0; i < COUNT * 4; i++) expected += i;
+    if (sum != expected) {
+        printf("chunk iteration error (exp=%ld, act=%ld)\n", expected, sum);
+        exit(1);
+    }
+
+    if (segvector_find(&vec, 2500) != 2500) {
+        printf("find error\n");
+        exit(1);
+    }
+
+    while (vec.size > 10) {
+        segvector_pop(&vec);
+    }
+
+    printf("segvector size=%d\n", vec.size);
+    printf("segvector chunks=%d\n", vec.n_chunks);
+
+    segvector_delete(&vec, 0);
+    if (segvector_get(&vec, 0) != 1 || vec.size != 9) {
+        printf("delete error\n");
+        exit(1);
+    }
+
+    segvector_clear(&vec);
+
+    printf("segvector size=%d\n", vec.size);
+    printf("segvector chunks=%d\n", vec.n_chunks);
+
+    return 0;
+
+}
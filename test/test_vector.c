@@ -12,6 +12,16 @@
 #include "jazlib/gen_vector.h"
 GEN_VECTOR(vector, int);
 
+#include "jazlib/gen_vector_reset.h"
+#define GEN_VECTOR_INLINE_CAPACITY 8
+#include "jazlib/gen_vector.h"
+GEN_VECTOR(small_vector, int);
+
+#include "jazlib/gen_vector_reset.h"
+#define GEN_VECTOR_INLINE_CAPACITY 32
+#include "jazlib/gen_vector.h"
+GEN_VECTOR(wide_vector, int);
+
 int main(int argc, char *argv[]) {
     
     vector_t vec;
@@ -42,6 +52,74 @@ int main(int argc, char *argv[]) {
     printf("vector size=%d\n", vec.size);
     printf("vector capacity=%d\n", vec.capacity);
     
+    vector_clear(&vec);
+    
+    small_vector_t svec;
+    small_vector_init(&svec);
+    
+    for (i = 0; i < 8; i++) {
+        small_vector_push(&svec, i);
+    }
+    
+    printf("small vector size=%d\n", svec.size);
+    printf("small vector capacity=%d\n", svec.capacity);
+    if (svec.values != NULL) { printf("small vector should be inline\n"); exit(1); }
+    
+    for (i = 8; i < 50; i++) {
+        small_vector_push(&svec, i);
+    }
+    
+    printf("small vector size=%d\n", svec.size);
+    printf("small vector capacity=%d\n", svec.capacity);
+    if (svec.values == NULL) { printf("small vector should have spilled\n"); exit(1); }
+    
+    for (i = 0; i < 50; i++) {
+        if (small_vector_get(&svec, i) != i) {
+            printf("small vector error (ix=%d)\n", i);
+            exit(1);
+        }
+    }
+    
+    while (svec.size > 2) {
+        small_vector_pop(&svec);
+    }
+    small_vector_push(&svec, 2);
+    
+    printf("small vector size=%d\n", svec.size);
+    printf("small vector capacity=%d\n", svec.capacity);
+    if (svec.values != NULL) { printf("small vector should be inline\n"); exit(1); }
+    if (small_vector_get(&svec, 0) != 0 || small_vector_get(&svec, 2) != 2) { printf("small vector error\n"); exit(1); }
+    
+    small_vector_clear(&svec);
+    
+    /* the common spill case: one element past inline, then back down */
+    for (i = 0; i < 9; i++) {
+        small_vector_push(&svec, i);
+    }
+    if (svec.values == NULL || svec.capacity != 16) { printf("small vector should have spilled to 16\n"); exit(1); }
+    while (svec.size > 1) {
+        small_vector_pop(&svec);
+    }
+    small_vector_set(&svec, 0, 42);
+    printf("small vector capacity=%d\n", svec.capacity);
+    if (svec.values != NULL) { printf("small vector should be inline after shrinking from 16\n"); exit(1); }
+    if (small_vector_get(&svec, 0) != 42) { printf("small vector error\n"); exit(1); }
+    small_vector_clear(&svec);
+    
+    /* shrinking must never pick a capacity that cannot hold ix */
+    wide_vector_t wvec;
+    wide_vector_init(&wvec);
+    for (i = 0; i < 40; i++) {
+        wide_vector_push(&wvec, i);
+    }
+    while (wvec.size > 10) {
+        wide_vector_pop(&wvec);
+    }
+    wide_vector_set(&wvec, 35, 35);
+    if (wvec.values == NULL || wvec.capacity <= 35 || wvec.size != 36) { printf("wide vector error (cap=%d)\n", wvec.capacity); exit(1); }
+    if (wide_vector_get(&wvec, 9) != 9 || wide_vector_get(&wvec, 35) != 35) { printf("wide vector error\n"); exit(1); }
+    wide_vector_clear(&wvec);
+    
     return 0;
 
 }
\ No newline at end of file